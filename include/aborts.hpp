@@ -67,16 +67,31 @@ namespace NP {
 
 	};
 
+	// Returns the position of the job of each abort action.
 	template<class Time>
-	void validate_abort_refs(const std::vector<Abort_action<Time>>& aborts,
-	                         const typename Job<Time>::Job_set jobs)
+	std::vector<std::size_t> resolve_abort_refs(
+		const std::vector<Abort_action<Time>>& aborts,
+		const typename Job<Time>::Job_set& jobs,
+		const Job_id_index& index)
 	{
-		for (auto action : aborts) {
-			auto job = lookup<Time>(jobs, action.get_id());
+		std::vector<std::size_t> positions;
+		positions.reserve(aborts.size());
+		for (const auto& action : aborts) {
+			auto i = index.position_of(action.get_id());
+			const Job<Time>& job = jobs[i];
 			if (action.earliest_trigger_time() < job.earliest_arrival() ||
 			    action.latest_trigger_time() < job.latest_arrival())
 				throw InvalidAbortParameter(action.get_id());
+			positions.push_back(i);
 		}
+		return positions;
+	}
+
+	template<class Time>
+	void validate_abort_refs(const std::vector<Abort_action<Time>>& aborts,
+	                         const typename Job<Time>::Job_set& jobs)
+	{
+		resolve_abort_refs<Time>(aborts, jobs, Job_id_index(jobs));
 	}
 
 
@@ -0,0 +1,142 @@
+#ifndef NP_ANALYSIS_HPP
+#define NP_ANALYSIS_HPP
+
+#include <vector>
+#include <stdexcept>
+
+#include "problem.hpp"
+#include "frontier.hpp"
+#include "uni/space.hpp"
+#include "global/space.hpp"
+
+// Library interface of the schedulability analysis: describe a problem
+// with a Scheduling_problem, pick an engine, and call NP::analyze().
+//
+// The analysis is thread-safe, so several analyses may run at the same
+// time in different threads. Note that with CONFIG_PARALLEL, the timeout
+// refers to the CPU time of the whole process.
+
+namespace NP {
+
+	// which state space to explore
+	enum class Analysis_engine {
+		// uniprocessor if the problem has one processor, global otherwise
+		automatic,
+		uniprocessor,
+		global
+	};
+
+	// idle-time insertion policy (uniprocessor analysis only)
+	enum class Idle_time_policy {
+		none,
+		precautious_rm,
+		critical_window
+	};
+
+	struct Engine_options {
+		Analysis_engine engine = Analysis_engine::automatic;
+		Idle_time_policy iip = Idle_time_policy::none;
+	};
+
+	template<class Time>
+	struct Analysis_results {
+		bool schedulable;
+		bool timed_out;
+		unsigned long number_of_states;
+		unsigned long number_of_edges;
+		unsigned long max_width;
+		double cpu_time;
+		// finish-time interval of each job, in the order of problem.jobs
+		std::vector<Interval<Time>> finish_times;
+		Workers_stats worker_stats;
+	};
+
+	// type tag that carries a state space type
+	template<class Space> struct State_space_tag {
+		typedef Space type;
+	};
+
+	// Calls f(State_space_tag<Space>()), where Space is the state space
+	// that implements the chosen engine. Global state spaces are
+	// specialized for some common numbers of processors. The IIP is
+	// ignored by the global engine.
+	template<class Time, class F>
+	auto with_state_space(unsigned int num_processors,
+	                      const Engine_options& engine, F f)
+		-> decltype(f(State_space_tag<Uniproc::State_space<Time>>()))
+	{
+		bool global = engine.engine == Analysis_engine::global
+		              || (engine.engine == Analysis_engine::automatic
+		                  && num_processors > 1);
+
+		if (global) {
+			switch (num_processors) {
+			case 2:
+				return f(State_space_tag<Global::State_space<Time, 2>>());
+			case 4:
+				return f(State_space_tag<Global::State_space<Time, 4>>());
+			case 8:
+				return f(State_space_tag<Global::State_space<Time, 8>>());
+			case 16:
+				return f(State_space_tag<Global::State_space<Time, 16>>());
+			default:
+				return f(State_space_tag<Global::State_space<Time>>());
+			}
+		}
+
+		switch (engine.iip) {
+		case Idle_time_policy::precautious_rm:
+			return f(State_space_tag<Uniproc::State_space<Time, Uniproc::Precatious_RM_IIP<Time>>>());
+		case Idle_time_policy::critical_window:
+			return f(State_space_tag<Uniproc::State_space<Time, Uniproc::Critical_window_IIP<Time>>>());
+		default:
+			return f(State_space_tag<Uniproc::State_space<Time>>());
+		}
+	}
+
+	// Analyze the given problem. Throws std::invalid_argument if the
+	// engine does not support the requested combination of options.
+	template<class Time>
+	Analysis_results<Time> analyze(const Scheduling_problem<Time>& problem,
+	                               const Analysis_options& opts = Analysis_options(),
+	                               const Engine_options& engine = Engine_options())
+	{
+		bool global = engine.engine == Analysis_engine::global
+		              || (engine.engine == Analysis_engine::automatic
+		                  && problem.num_processors > 1);
+
+		if (global && engine.iip != Idle_time_policy::none)
+			throw std::invalid_argument("IIPs are not supported by the global analysis");
+		if (global && !opts.early_exit)
+			throw std::invalid_argument("the global analysis always stops at the first deadline miss");
+		if (!global && problem.num_processors != 1)
+			throw std::invalid_argument("the uniprocessor analysis requires exactly one processor");
+		if (!global && opts.frontier_budget)
+			throw std::invalid_argument("the uniprocessor analysis does not spill states");
+
+		return with_state_space<Time>(problem.num_processors, engine, [&] (auto tag) {
+			typedef typename decltype(tag)::type Space;
+
+			auto space = Space::explore(problem, opts);
+
+			Analysis_results<Time> results{
+				space.is_schedulable(),
+				space.was_timed_out(),
+				space.number_of_states(),
+				space.number_of_edges(),
+				space.max_exploration_front_width(),
+				space.get_cpu_time(),
+				{},
+				space.get_worker_stats()
+			};
+
+			results.finish_times.reserve(problem.jobs.size());
+			for (std::size_t i = 0; i < problem.jobs.size(); i++)
+				results.finish_times.push_back(space.get_finish_times(i));
+
+			return results;
+		});
+	}
+}
+
+#endif
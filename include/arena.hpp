@@ -0,0 +1,449 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <iterator>
+#include <utility>
+#include <mutex>
+
+namespace NP {
+
+	// Process-wide pool of the memory chunks of destroyed arenas. The
+	// exploration creates and destroys arenas at every depth, and a
+	// long-running process analyzes one problem after another, so chunks
+	// are recycled instead of being returned to the system allocator.
+	//
+	// Pooled chunks are kept in free lists by size class: class c holds
+	// the chunks of 2^c to 2^(c+1) - 1 bytes. Since arenas grow their
+	// chunks geometrically, most chunks are powers of two, and a request
+	// is served in constant time from the head of one or two lists. A few
+	// chunks per thread are kept in a small cache in front of the shared
+	// lists, so that a thread that keeps destroying and creating arenas
+	// rarely needs to take the lock.
+	class Arena_chunk_pool
+	{
+		public:
+
+		static Arena_chunk_pool& instance()
+		{
+			static Arena_chunk_pool pool;
+			return pool;
+		}
+
+		// Returns a pooled chunk of at least the given size (but not
+		// wastefully larger), or nullptr.
+		char* take(std::size_t at_least, std::size_t& size)
+		{
+			Chunk c;
+			if (!local_cache().take(at_least, c) && !take_shared(at_least, c))
+				return nullptr;
+			size = c.size;
+			return c.mem;
+		}
+
+		void give(char* mem, std::size_t size)
+		{
+			if (local_cache().give(Chunk{mem, size}))
+				return;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if (cached + size <= max_cached) {
+					free_lists[size_class(size)].push_back(Chunk{mem, size});
+					cached += size;
+					return;
+				}
+			}
+			::operator delete(mem);
+		}
+
+		~Arena_chunk_pool()
+		{
+			for (auto& l : free_lists)
+				for (auto& c : l)
+					::operator delete(c.mem);
+		}
+
+		private:
+
+		struct Chunk {
+			char* mem;
+			std::size_t size;
+		};
+
+		static const std::size_t max_cached = std::size_t(256) << 20;
+		static const unsigned int num_classes = 64;
+
+		// chunks that are more than twice as large as requested are
+		// not handed out
+		static bool fits(const Chunk& c, std::size_t at_least)
+		{
+			return c.size >= at_least && c.size <= 2 * at_least;
+		}
+
+		// floor(log2(size)), for size > 0
+		static unsigned int size_class(std::size_t size)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			return 63 - __builtin_clzll(size);
+#else
+			unsigned int c = 0;
+			while (size >>= 1)
+				c++;
+			return c;
+#endif
+		}
+
+		bool take_shared(std::size_t at_least, Chunk& c)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			// The most recently pooled chunk of the request's own class
+			// may be large enough; every chunk of the next class is.
+			unsigned int lower = size_class(at_least);
+			for (unsigned int k = lower; k <= lower + 1 && k < num_classes; k++) {
+				auto& l = free_lists[k];
+				if (!l.empty() && fits(l.back(), at_least)) {
+					c = l.back();
+					l.pop_back();
+					cached -= c.size;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// A few recently released chunks of the calling thread. Chunks
+		// that are still cached when the thread ends are freed rather than
+		// pooled, since the pool may be gone by then.
+		class Local_cache
+		{
+			public:
+
+			bool take(std::size_t at_least, Chunk& c)
+			{
+				for (std::size_t i = 0; i < count; i++)
+					if (fits(chunks[i], at_least)) {
+						c = chunks[i];
+						chunks[i] = chunks[--count];
+						return true;
+					}
+				return false;
+			}
+
+			bool give(const Chunk& c)
+			{
+				if (count == max_chunks || c.size > max_chunk_size)
+					return false;
+				chunks[count++] = c;
+				return true;
+			}
+
+			~Local_cache()
+			{
+				for (std::size_t i = 0; i < count; i++)
+					::operator delete(chunks[i].mem);
+			}
+
+			private:
+
+			static const std::size_t max_chunks = 8;
+			static const std::size_t max_chunk_size = 1 << 20;
+
+			Chunk chunks[max_chunks];
+			std::size_t count = 0;
+		};
+
+		static Local_cache& local_cache()
+		{
+			static thread_local Local_cache cache;
+			return cache;
+		}
+
+		std::mutex lock;
+		std::vector<Chunk> free_lists[num_classes];
+		std::size_t cached = 0;
+	};
+
+	// A simple monotonic ("bump") allocator. Memory is carved out of
+	// increasingly large chunks and is never freed individually: it is
+	// released all at once by reset() or when the arena is destroyed.
+	// An arena is not thread-safe; each thread should use its own.
+	class Arena
+	{
+		public:
+
+		// position in the arena, used to undo the most recent allocations
+		struct Mark {
+			std::size_t chunk;
+			std::size_t used;
+		};
+
+		Arena()
+		: current(0)
+		, used(0)
+		{
+		}
+
+		~Arena()
+		{
+			for (auto& c : chunks)
+				Arena_chunk_pool::instance().give(c.mem, c.size);
+		}
+
+		void* allocate(std::size_t bytes,
+		               std::size_t align = alignof(std::max_align_t))
+		{
+			while (true) {
+				if (current < chunks.size()) {
+					auto addr = reinterpret_cast<std::uintptr_t>(chunks[current].mem);
+					auto offset = (addr + used + align - 1) / align * align - addr;
+					if (offset + bytes <= chunks[current].size) {
+						used = offset + bytes;
+						return chunks[current].mem + offset;
+					}
+					// move on to the next chunk, if there is one already
+					if (current + 1 < chunks.size()) {
+						current++;
+						used = 0;
+						continue;
+					}
+				}
+				add_chunk(bytes + align);
+			}
+		}
+
+		Mark mark() const
+		{
+			return Mark{current, used};
+		}
+
+		// release everything that was allocated since the given mark
+		void rollback(const Mark& m)
+		{
+			current = m.chunk;
+			used = m.used;
+		}
+
+		// release everything, but keep the chunks for reuse
+		void reset()
+		{
+			current = 0;
+			used = 0;
+		}
+
+		private:
+
+		static const std::size_t min_chunk_size = 4096;
+		static const std::size_t max_chunk_size = 1 << 20;
+
+		struct Chunk {
+			char* mem;
+			std::size_t size;
+		};
+
+		std::vector<Chunk> chunks;
+		std::size_t current;
+		std::size_t used;
+
+		void add_chunk(std::size_t at_least)
+		{
+			// grow geometrically so that small arenas stay small
+			std::size_t size = chunks.empty() ? std::size_t(min_chunk_size)
+			                   : std::min(chunks.back().size * 2,
+			                              std::size_t(max_chunk_size));
+			size = std::max(size, at_least);
+			char* mem = Arena_chunk_pool::instance().take(size, size);
+			if (!mem)
+				mem = static_cast<char*>(::operator new(size));
+			chunks.push_back(Chunk{mem, size});
+			current = chunks.size() - 1;
+			used = 0;
+		}
+
+		// no accidental copies
+		Arena(const Arena& origin) = delete;
+		Arena& operator=(const Arena& origin) = delete;
+	};
+
+	// STL allocator that takes its memory from an arena. Deallocation is a
+	// no-op; the memory is reclaimed when the arena is reset. Without an
+	// arena, it falls back to the regular heap.
+	template<class T> class Arena_allocator
+	{
+		public:
+
+		typedef T value_type;
+
+		Arena_allocator(Arena* arena = nullptr)
+		: arena(arena)
+		{
+		}
+
+		template<class U>
+		Arena_allocator(const Arena_allocator<U>& other)
+		: arena(other.get_arena())
+		{
+		}
+
+		T* allocate(std::size_t n)
+		{
+			if (arena)
+				return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+			else
+				return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+
+		void deallocate(T* p, std::size_t /*n*/)
+		{
+			if (!arena)
+				::operator delete(p);
+		}
+
+		Arena* get_arena() const
+		{
+			return arena;
+		}
+
+		template<class U>
+		bool operator==(const Arena_allocator<U>& other) const
+		{
+			return arena == other.get_arena();
+		}
+
+		template<class U>
+		bool operator!=(const Arena_allocator<U>& other) const
+		{
+			return arena != other.get_arena();
+		}
+
+		private:
+
+		Arena* arena;
+	};
+
+	// A sequence of objects that live in a common arena, together with
+	// everything that they allocate through an Arena_allocator. Elements
+	// are constructed in place, with the arena's allocator appended to the
+	// constructor arguments, and are never moved. clear() discards all
+	// elements and releases their memory at once.
+	template<class T> class Arena_sequence
+	{
+		typedef std::vector<T*> Elements;
+
+		public:
+
+		typedef T value_type;
+		typedef Arena_allocator<char> Allocator;
+
+		class const_iterator
+		{
+			public:
+
+			typedef std::forward_iterator_tag iterator_category;
+			typedef T value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef const T* pointer;
+			typedef const T& reference;
+
+			const_iterator(typename Elements::const_iterator it)
+			: it(it)
+			{
+			}
+
+			reference operator*() const { return **it; }
+			pointer operator->() const { return *it; }
+			const_iterator& operator++() { ++it; return *this; }
+			const_iterator operator++(int) { return const_iterator(it++); }
+			bool operator==(const const_iterator& other) const { return it == other.it; }
+			bool operator!=(const const_iterator& other) const { return it != other.it; }
+
+			private:
+
+			typename Elements::const_iterator it;
+		};
+
+		typedef const_iterator iterator;
+
+		Arena_sequence()
+		{
+		}
+
+		~Arena_sequence()
+		{
+			clear();
+		}
+
+		template <typename... Args>
+		T& emplace_back(Args&&... args)
+		{
+			last = arena.mark();
+			void* mem = arena.allocate(sizeof(T), alignof(T));
+			T* elem = new (mem) T(std::forward<Args>(args)..., Allocator(&arena));
+			elements.push_back(elem);
+			return *elem;
+		}
+
+		// discard the most recently added element (only once)
+		void pop_back()
+		{
+			elements.back()->~T();
+			elements.pop_back();
+			arena.rollback(last);
+		}
+
+		T& back()
+		{
+			return *elements.back();
+		}
+
+		T& operator[](std::size_t i)
+		{
+			return *elements[i];
+		}
+
+		const T& operator[](std::size_t i) const
+		{
+			return *elements[i];
+		}
+
+		std::size_t size() const
+		{
+			return elements.size();
+		}
+
+		bool empty() const
+		{
+			return elements.empty();
+		}
+
+		const_iterator begin() const
+		{
+			return const_iterator(elements.begin());
+		}
+
+		const_iterator end() const
+		{
+			return const_iterator(elements.end());
+		}
+
+		void clear()
+		{
+			for (T* elem : elements)
+				elem->~T();
+			elements.clear();
+			arena.reset();
+		}
+
+		private:
+
+		Arena arena;
+		Elements elements;
+		Arena::Mark last;
+	};
+}
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef BINARY_IO_HPP
+#define BINARY_IO_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "time.hpp"
+#include "jobs.hpp"
+#include "precedence.hpp"
+#include "aborts.hpp"
+
+// Binary job-set format
+// =====================
+//
+// A binary job set consists of a header followed by three tables of
+// fixed-width records: the jobs, the precedence constraints, and the
+// abort actions. All fields are stored in the byte order of the machine
+// that wrote the file; the header records that byte order so that
+// foreign files are rejected instead of misread. Time values are 64-bit
+// integers for discrete time and 64-bit doubles for dense time.
+
+namespace NP {
+
+	namespace Binary {
+
+		const char magic[8] = {'N', 'P', 'J', 'O', 'B', 'S', 'E', 'T'};
+		const std::uint32_t version = 1;
+		const std::uint32_t byte_order_mark = 0x01020304;
+
+		enum Time_model : std::uint32_t {
+			discrete = 0,
+			dense = 1
+		};
+
+		struct Header {
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t byte_order;
+			std::uint32_t time_model;
+			std::uint32_t reserved;
+			std::uint64_t num_jobs;
+			std::uint64_t num_edges;
+			std::uint64_t num_aborts;
+		};
+
+		template<class Time> struct Job_record {
+			std::uint64_t task, job;
+			Time arrival_min, arrival_max;
+			Time cost_min, cost_max;
+			Time deadline, priority;
+		};
+
+		struct Edge_record {
+			std::uint64_t from_task, from_job;
+			std::uint64_t to_task, to_job;
+		};
+
+		template<class Time> struct Abort_record {
+			std::uint64_t task, job;
+			Time trigger_min, trigger_max;
+			Time cleanup_min, cleanup_max;
+		};
+
+		template<class Time> Time_model time_model_of()
+		{
+			static_assert(sizeof(Time) == 8, "binary job sets store 64-bit time values");
+			return std::is_integral<Time>::value ? discrete : dense;
+		}
+
+		inline const char* time_model_name(std::uint32_t model)
+		{
+			return model == discrete ? "discrete" : "dense";
+		}
+	}
+
+	// all inputs of an analysis that a binary job set carries
+	template<class Time> struct Binary_job_set {
+		typename Job<Time>::Job_set jobs;
+		Precedence_constraints edges;
+		std::vector<Abort_action<Time>> aborts;
+	};
+
+	inline bool is_binary_job_set(const char* begin, const char* end)
+	{
+		return (std::size_t) (end - begin) >= sizeof(Binary::magic)
+		       && std::memcmp(begin, Binary::magic, sizeof(Binary::magic)) == 0;
+	}
+
+	template<class Time>
+	void write_binary_job_set(std::ostream& out,
+	                          const typename Job<Time>::Job_set& jobs,
+	                          const Precedence_constraints& edges,
+	                          const std::vector<Abort_action<Time>>& aborts)
+	{
+		Binary::Header header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, Binary::magic, sizeof(header.magic));
+		header.version = Binary::version;
+		header.byte_order = Binary::byte_order_mark;
+		header.time_model = Binary::time_model_of<Time>();
+		header.num_jobs = jobs.size();
+		header.num_edges = edges.size();
+		header.num_aborts = aborts.size();
+
+		auto write = [&] (const void* data, std::size_t size) {
+			out.write(static_cast<const char*>(data), size);
+		};
+
+		write(&header, sizeof(header));
+
+		for (const auto& j : jobs) {
+			Binary::Job_record<Time> r{
+				j.get_task_id(), j.get_job_id(),
+				j.earliest_arrival(), j.latest_arrival(),
+				j.least_cost(), j.maximal_cost(),
+				j.get_deadline(), j.get_priority()};
+			write(&r, sizeof(r));
+		}
+
+		for (const auto& e : edges) {
+			Binary::Edge_record r{
+				e.first.task, e.first.job,
+				e.second.task, e.second.job};
+			write(&r, sizeof(r));
+		}
+
+		for (const auto& a : aborts) {
+			Binary::Abort_record<Time> r{
+				a.get_id().task, a.get_id().job,
+				a.earliest_trigger_time(), a.latest_trigger_time(),
+				a.least_cleanup_cost(), a.maximum_cleanup_cost()};
+			write(&r, sizeof(r));
+		}
+
+		if (!out)
+			throw std::ios_base::failure("could not write binary job set");
+	}
+
+	// Load a binary job set from the bytes in [begin, end), e.g., a
+	// memory-mapped file. Throws std::ios_base::failure if the data is
+	// not a valid binary job set, and std::invalid_argument if it was
+	// written for the other time model.
+	template<class Time>
+	Binary_job_set<Time> parse_binary_job_set(const char* begin, const char* end)
+	{
+		std::size_t size = end - begin;
+
+		Binary::Header header;
+		if (!is_binary_job_set(begin, end) || size < sizeof(header))
+			throw std::ios_base::failure("not a binary job set");
+		std::memcpy(&header, begin, sizeof(header));
+
+		if (header.byte_order != Binary::byte_order_mark)
+			throw std::ios_base::failure("binary job set has a foreign byte order");
+		if (header.version != Binary::version)
+			throw std::ios_base::failure("unsupported binary job set version");
+		if (header.time_model != Binary::time_model_of<Time>())
+			throw std::invalid_argument(
+				std::string("binary job set uses ")
+				+ Binary::time_model_name(header.time_model) + " time");
+
+		// the tables must fill the rest of the file exactly
+		const std::uint64_t max_records = size / sizeof(Binary::Edge_record);
+		if (header.num_jobs > max_records || header.num_edges > max_records
+		    || header.num_aborts > max_records
+		    || size != sizeof(header)
+		               + header.num_jobs * sizeof(Binary::Job_record<Time>)
+		               + header.num_edges * sizeof(Binary::Edge_record)
+		               + header.num_aborts * sizeof(Binary::Abort_record<Time>))
+			throw std::ios_base::failure("truncated or corrupted binary job set");
+
+		// the records are copied out since the buffer need not be aligned
+		const char* pos = begin + sizeof(header);
+		auto read = [&pos] (void* record, std::size_t size) {
+			std::memcpy(record, pos, size);
+			pos += size;
+		};
+
+		Binary_job_set<Time> input;
+
+		input.jobs.reserve(header.num_jobs);
+		for (std::uint64_t i = 0; i < header.num_jobs; i++) {
+			Binary::Job_record<Time> r;
+			read(&r, sizeof(r));
+			input.jobs.push_back(Job<Time>{r.job,
+				Interval<Time>{r.arrival_min, r.arrival_max},
+				Interval<Time>{r.cost_min, r.cost_max},
+				r.deadline, r.priority, r.task});
+		}
+
+		input.edges.reserve(header.num_edges);
+		for (std::uint64_t i = 0; i < header.num_edges; i++) {
+			Binary::Edge_record r;
+			read(&r, sizeof(r));
+			input.edges.push_back(Precedence_constraint(
+				JobID(r.from_job, r.from_task), JobID(r.to_job, r.to_task)));
+		}
+
+		input.aborts.reserve(header.num_aborts);
+		for (std::uint64_t i = 0; i < header.num_aborts; i++) {
+			Binary::Abort_record<Time> r;
+			read(&r, sizeof(r));
+			input.aborts.push_back(Abort_action<Time>{JobID{r.job, r.task},
+				Interval<Time>{r.trigger_min, r.trigger_max},
+				Interval<Time>{r.cleanup_min, r.cleanup_max}});
+		}
+
+		return input;
+	}
+}
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "problem.hpp"
+#include "binary_io.hpp"
+
+// Checkpoints
+// ===========
+//
+// Both analyses explore the state space depth by depth. At the start of
+// a depth, everything an analysis still needs is the front (the states
+// of that depth), the finish-time bounds found so far, and a few
+// counters. A checkpoint stores exactly this, so that an analysis can
+// later continue from it and obtain the same results as if it had never
+// been interrupted.
+//
+// A checkpoint file consists of a header, the finish-time bounds of all
+// jobs (two time values per job), and the front in a format that is
+// specific to the analysis that wrote it. Like binary job sets, all
+// fields are stored in the byte order of the machine that wrote them.
+// The header identifies the problem and the options that affect the
+// results, so that a checkpoint is not resumed by a different analysis.
+
+namespace NP {
+
+	namespace Checkpoint {
+
+		const char magic[8] = {'N', 'P', 'C', 'H', 'E', 'C', 'K', 'P'};
+		const std::uint32_t version = 3;
+
+		enum Flags : std::uint32_t {
+			naive = 1,
+			early_exit = 2,
+			deadline_miss = 4
+		};
+
+		struct Header {
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t byte_order;
+			std::uint32_t time_model;
+			// which analysis wrote the checkpoint
+			std::uint32_t engine;
+			std::uint64_t problem;
+			std::uint32_t num_processors;
+			std::uint32_t flags;
+			// the depth of the front
+			std::uint64_t depth;
+			std::uint64_t num_states;
+			std::uint64_t num_edges;
+			std::uint64_t width;
+			double cpu_time;
+		};
+
+		// one step of SplitMix64 (as in job_fingerprint()), applied to the
+		// hash so far combined with the next value
+		inline std::uint64_t mix(std::uint64_t h, std::uint64_t x)
+		{
+			std::uint64_t z = (h ^ x) + 0x9e3779b97f4a7c15ULL;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			return z ^ (z >> 31);
+		}
+
+		// the bits of a time value, so that dense times hash exactly
+		template<class Time>
+		std::uint64_t bits_of(Time t)
+		{
+			static_assert(sizeof(Time) <= sizeof(std::uint64_t),
+			              "time values must fit into 64 bits");
+			std::uint64_t x = 0;
+			std::memcpy(&x, &t, sizeof(t));
+			return x;
+		}
+
+		// hash of everything that defines the problem
+		template<class Time>
+		std::uint64_t fingerprint(const Scheduling_problem<Time>& prob)
+		{
+			std::uint64_t h = 0;
+			h = mix(h, prob.num_processors);
+			h = mix(h, prob.jobs.size());
+			for (const auto& j : prob.jobs) {
+				h = mix(h, j.get_id().task);
+				h = mix(h, j.get_id().job);
+				h = mix(h, bits_of(j.earliest_arrival()));
+				h = mix(h, bits_of(j.latest_arrival()));
+				h = mix(h, bits_of(j.least_cost()));
+				h = mix(h, bits_of(j.maximal_cost()));
+				h = mix(h, bits_of(j.get_deadline()));
+				h = mix(h, bits_of(j.get_priority()));
+			}
+			h = mix(h, prob.resolved_dag.size());
+			for (const auto& e : prob.resolved_dag) {
+				h = mix(h, e.first);
+				h = mix(h, e.second);
+			}
+			h = mix(h, prob.aborts.size());
+			for (std::size_t i = 0; i < prob.aborts.size(); i++) {
+				const auto& a = prob.aborts[i];
+				h = mix(h, prob.abort_job_positions[i]);
+				h = mix(h, bits_of(a.earliest_trigger_time()));
+				h = mix(h, bits_of(a.latest_trigger_time()));
+				h = mix(h, bits_of(a.least_cleanup_cost()));
+				h = mix(h, bits_of(a.maximum_cleanup_cost()));
+			}
+			return h;
+		}
+
+		// the header of a checkpoint of the given problem (without counters)
+		template<class Time>
+		Header make_header(const Scheduling_problem<Time>& prob,
+		                   const Analysis_options& opts, std::uint32_t engine)
+		{
+			Header h;
+			std::memset(&h, 0, sizeof(h));
+			std::memcpy(h.magic, magic, sizeof(h.magic));
+			h.version = version;
+			h.byte_order = Binary::byte_order_mark;
+			h.time_model = Binary::time_model_of<Time>();
+			h.engine = engine;
+			h.problem = fingerprint(prob);
+			h.num_processors = prob.num_processors;
+			h.flags = 0;
+			if (opts.be_naive)
+				h.flags |= naive;
+			if (opts.early_exit)
+				h.flags |= early_exit;
+			return h;
+		}
+
+		// Writes a checkpoint to a temporary file that replaces the
+		// checkpoint file only once it is complete, so that a crash while
+		// writing leaves the previous checkpoint intact.
+		class Writer
+		{
+			public:
+
+			explicit Writer(const std::string& fname)
+			: fname(fname)
+			, tmp_name(fname + ".tmp")
+			, out(tmp_name, std::ios::out | std::ios::binary | std::ios::trunc)
+			{
+				if (!out)
+					throw std::runtime_error("cannot write checkpoint " + tmp_name);
+			}
+
+			void write(const void* data, std::size_t size)
+			{
+				out.write(static_cast<const char*>(data), size);
+			}
+
+			template<class T> void write_value(const T& x)
+			{
+				write(&x, sizeof(x));
+			}
+
+			template<class Time>
+			void write_finish_times(const std::vector<std::pair<Time, Time>>& rta)
+			{
+				for (const auto& r : rta) {
+					write_value(r.first);
+					write_value(r.second);
+				}
+			}
+
+			void commit()
+			{
+				out.close();
+				if (!out || std::rename(tmp_name.c_str(), fname.c_str()))
+					throw std::runtime_error("cannot write checkpoint " + fname);
+			}
+
+			private:
+
+			std::string fname, tmp_name;
+			std::ofstream out;
+		};
+
+		class Reader
+		{
+			public:
+
+			explicit Reader(const std::string& fname)
+			: fname(fname)
+			, in(fname, std::ios::in | std::ios::binary)
+			{
+				if (!in)
+					throw std::runtime_error("cannot open checkpoint " + fname);
+			}
+
+			void read(void* data, std::size_t size)
+			{
+				if (!in.read(static_cast<char*>(data), size))
+					throw std::runtime_error("truncated checkpoint " + fname);
+			}
+
+			template<class T> T read_value()
+			{
+				T x;
+				read(&x, sizeof(x));
+				return x;
+			}
+
+			// Reads the header and checks that it matches the expected one
+			// (as returned by make_header()). Throws std::runtime_error if not.
+			Header read_header(const Header& expected)
+			{
+				Header h;
+				read(&h, sizeof(h));
+				if (std::memcmp(h.magic, magic, sizeof(magic)))
+					throw std::runtime_error(fname + " is not a checkpoint");
+				if (h.byte_order != expected.byte_order || h.version != expected.version)
+					throw std::runtime_error(fname + ": unsupported checkpoint version "
+					                         "or byte order");
+				if (h.time_model != expected.time_model || h.engine != expected.engine
+				    || h.problem != expected.problem
+				    || h.num_processors != expected.num_processors
+				    || (h.flags & (naive | early_exit)) != expected.flags)
+					throw std::runtime_error(fname + " was written by an analysis "
+					                         "of a different problem or with "
+					                         "different options");
+				return h;
+			}
+
+			template<class Time>
+			void read_finish_times(std::vector<std::pair<Time, Time>>& rta)
+			{
+				for (auto& r : rta) {
+					r.first = read_value<Time>();
+					r.second = read_value<Time>();
+				}
+			}
+
+			private:
+
+			std::string fname;
+			std::ifstream in;
+		};
+
+		inline bool exists(const std::string& fname)
+		{
+			return (bool) std::ifstream(fname);
+		}
+	}
+}
+
+#endif
@@ -3,41 +3,62 @@
 
 #include <time.h>
 
+#include "config.h"
+
+// Measures CPU time. A sequential analysis runs entirely in the calling
+// thread, so where possible only that thread's CPU time is counted; this
+// way, analyses that run concurrently in one process (e.g., in nptest's
+// server mode) are not charged for each other. The parallel analysis
+// uses many threads and thus counts the CPU time of the whole process.
 class Processor_clock {
 
 	private:
 
-	clock_t accum = 0, start_time = 0;
+	double accum = 0, start_time = 0;
 	bool running = false;
 
-	static constexpr double scale_to_seconds = 1.0 / (double) CLOCKS_PER_SEC;
+	static double now()
+	{
+#if !defined(CONFIG_PARALLEL) && defined(CLOCK_THREAD_CPUTIME_ID)
+		struct timespec ts;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+			return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+		return clock() / (double) CLOCKS_PER_SEC;
+	}
 
 	public:
 
 	void start()
 	{
 		running = true;
-		start_time = clock();
+		start_time = now();
 	}
 
 
 	double stop()
 	{
-		auto delta = clock() - start_time;
+		auto delta = now() - start_time;
 		if (running) {
 			accum += delta;
 			running = false;
-			return delta * scale_to_seconds;
+			return delta;
 		}
 		else
 			return 0;
 	}
 
+	// account for time spent before (e.g., by an interrupted analysis)
+	void add(double seconds)
+	{
+		accum += seconds;
+	}
+
 	operator double() const {
-		clock_t extra = 0;
+		double extra = 0;
 		if (running)
-			extra = clock() - start_time;
-		return (accum + extra) * scale_to_seconds;
+			extra = now() - start_time;
+		return accum + extra;
 	}
 
 };
@@ -0,0 +1,141 @@
+#ifndef FRONTIER_HPP
+#define FRONTIER_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "config.h"
+
+#ifdef CONFIG_PARALLEL
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cassert>
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+#endif
+
+namespace NP {
+
+	// how much time a worker of the parallel analysis spent exploring
+	// states (busy) and waiting for the rest of a depth to finish (idle)
+	struct Worker_stats {
+		double busy = 0;
+		double idle = 0;
+		unsigned long num_states = 0;
+	};
+
+	typedef std::vector<Worker_stats> Workers_stats;
+
+#ifdef CONFIG_PARALLEL
+
+	// Distributes the exploration front of one depth among the workers.
+	//
+	// The front is given as a number of buckets of states (typically one
+	// per thread that created them), which can be very unevenly filled.
+	// The scheduler cuts all buckets into chunks of a fixed number of
+	// states, and each worker repeatedly grabs the next unprocessed chunk
+	// until none are left.
+	class Frontier_scheduler
+	{
+		public:
+
+		Frontier_scheduler(std::size_t chunk_size = 64)
+		: chunk_size(chunk_size)
+		{
+		}
+
+		// Calls process(s) for each state s in each bucket. The buckets
+		// must provide size() and operator[].
+		template<class Buckets, class Process>
+		void run(const Buckets& buckets, Process process)
+		{
+			typedef typename Buckets::value_type Bucket;
+
+			std::vector<Chunk<Bucket>> chunks;
+			for (const Bucket& b : buckets)
+				for (std::size_t i = 0; i < b.size(); i += chunk_size)
+					chunks.push_back(Chunk<Bucket>{&b, i, std::min(i + chunk_size, b.size())});
+
+			distribute(chunks, [&] (const Chunk<Bucket>& chunk) {
+				for (std::size_t i = chunk.begin; i < chunk.end; i++)
+					process((*chunk.bucket)[i]);
+			});
+		}
+
+		// Calls process(i) for each i in [0, n).
+		template<class Process>
+		void run_range(std::size_t n, Process process)
+		{
+			std::vector<Chunk<void>> chunks;
+			for (std::size_t i = 0; i < n; i += chunk_size)
+				chunks.push_back(Chunk<void>{nullptr, i, std::min(i + chunk_size, n)});
+
+			distribute(chunks, [&] (const Chunk<void>& chunk) {
+				for (std::size_t i = chunk.begin; i < chunk.end; i++)
+					process(i);
+			});
+		}
+
+		const Workers_stats& get_stats() const
+		{
+			return stats;
+		}
+
+		private:
+
+		typedef std::chrono::steady_clock Clock;
+
+		template<class Bucket> struct Chunk {
+			const Bucket* bucket;
+			std::size_t begin, end;
+		};
+
+		const std::size_t chunk_size;
+		Workers_stats stats;
+
+		template<class Chunks, class Process_chunk>
+		void distribute(const Chunks& chunks, Process_chunk process_chunk)
+		{
+			int num_workers = tbb::this_task_arena::max_concurrency();
+			if (stats.size() < (std::size_t) num_workers)
+				stats.resize(num_workers);
+
+			std::atomic<std::size_t> next(0);
+			auto start = Clock::now();
+			std::vector<double> busy(num_workers, 0);
+
+			// One task per worker, but TBB may run several of them on
+			// the same thread, so the time is accounted to the thread
+			// that actually ran the chunks.
+			tbb::parallel_for(tbb::blocked_range<int>(0, num_workers, 1),
+				[&] (const tbb::blocked_range<int>&) {
+					int w = tbb::this_task_arena::current_thread_index();
+					assert(w >= 0 && w < num_workers);
+					std::size_t c;
+					while ((c = next.fetch_add(1)) < chunks.size()) {
+						auto t = Clock::now();
+						process_chunk(chunks[c]);
+						busy[w] += seconds(Clock::now() - t);
+						stats[w].num_states += chunks[c].end - chunks[c].begin;
+					}
+				}, tbb::simple_partitioner());
+
+			double elapsed = seconds(Clock::now() - start);
+			for (int w = 0; w < num_workers; w++) {
+				stats[w].busy += busy[w];
+				stats[w].idle += std::max(0.0, elapsed - busy[w]);
+			}
+		}
+
+		static double seconds(Clock::duration d)
+		{
+			return std::chrono::duration<double>(d).count();
+		}
+	};
+
+#endif
+}
+
+#endif
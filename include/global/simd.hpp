@@ -0,0 +1,194 @@
+#ifndef GLOBAL_SIMD_HPP
+#define GLOBAL_SIMD_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace NP {
+
+	namespace Global {
+
+		// Kernels for checking and merging the core availability of two
+		// states. Intervals are given as separate arrays of lower and
+		// upper bounds. Vectorized versions are used for integer (dtime_t)
+		// and floating-point (dense_t) time if the target supports them
+		// (e.g., when compiling with -march=native); the scalar versions
+		// serve as fallback.
+		namespace Simd {
+
+			// Do all intervals [a_lo[i], a_hi[i]] and [b_lo[i], b_hi[i]]
+			// intersect? Same semantics as Interval::intersects().
+			template<class T>
+			inline bool all_intersect_scalar(const T* a_lo, const T* a_hi,
+			                                 const T* b_lo, const T* b_hi,
+			                                 std::size_t n, T eps)
+			{
+				for (std::size_t i = 0; i < n; i++)
+					if (b_hi[i] + eps < a_lo[i] || a_hi[i] + eps < b_lo[i])
+						return false;
+				return true;
+			}
+
+			// Widen the intervals in a to also cover those in b.
+			template<class T>
+			inline void widen_scalar(T* a_lo, T* a_hi,
+			                         const T* b_lo, const T* b_hi,
+			                         std::size_t n)
+			{
+				for (std::size_t i = 0; i < n; i++) {
+					a_lo[i] = std::min(a_lo[i], b_lo[i]);
+					a_hi[i] = std::max(a_hi[i], b_hi[i]);
+				}
+			}
+
+			template<class T>
+			inline bool all_intersect(const T* a_lo, const T* a_hi,
+			                          const T* b_lo, const T* b_hi,
+			                          std::size_t n, T eps)
+			{
+				return all_intersect_scalar(a_lo, a_hi, b_lo, b_hi, n, eps);
+			}
+
+			template<class T>
+			inline void widen(T* a_lo, T* a_hi, const T* b_lo, const T* b_hi,
+			                  std::size_t n)
+			{
+				widen_scalar(a_lo, a_hi, b_lo, b_hi, n);
+			}
+
+			inline bool all_intersect(const long long* a_lo, const long long* a_hi,
+			                          const long long* b_lo, const long long* b_hi,
+			                          std::size_t n, long long eps)
+			{
+				std::size_t i = 0;
+#if defined(__AVX2__)
+				const __m256i e = _mm256_set1_epi64x(eps);
+				for (; i + 4 <= n; i += 4) {
+					__m256i al = _mm256_loadu_si256((const __m256i*) (a_lo + i));
+					__m256i ah = _mm256_loadu_si256((const __m256i*) (a_hi + i));
+					__m256i bl = _mm256_loadu_si256((const __m256i*) (b_lo + i));
+					__m256i bh = _mm256_loadu_si256((const __m256i*) (b_hi + i));
+					__m256i disjoint = _mm256_or_si256(
+						_mm256_cmpgt_epi64(al, _mm256_add_epi64(bh, e)),
+						_mm256_cmpgt_epi64(bl, _mm256_add_epi64(ah, e)));
+					if (!_mm256_testz_si256(disjoint, disjoint))
+						return false;
+				}
+#elif defined(__SSE4_2__)
+				const __m128i e = _mm_set1_epi64x(eps);
+				for (; i + 2 <= n; i += 2) {
+					__m128i al = _mm_loadu_si128((const __m128i*) (a_lo + i));
+					__m128i ah = _mm_loadu_si128((const __m128i*) (a_hi + i));
+					__m128i bl = _mm_loadu_si128((const __m128i*) (b_lo + i));
+					__m128i bh = _mm_loadu_si128((const __m128i*) (b_hi + i));
+					__m128i disjoint = _mm_or_si128(
+						_mm_cmpgt_epi64(al, _mm_add_epi64(bh, e)),
+						_mm_cmpgt_epi64(bl, _mm_add_epi64(ah, e)));
+					if (!_mm_testz_si128(disjoint, disjoint))
+						return false;
+				}
+#endif
+				return all_intersect_scalar(a_lo + i, a_hi + i, b_lo + i, b_hi + i,
+				                            n - i, eps);
+			}
+
+			inline void widen(long long* a_lo, long long* a_hi,
+			                  const long long* b_lo, const long long* b_hi,
+			                  std::size_t n)
+			{
+				std::size_t i = 0;
+#if defined(__AVX2__)
+				for (; i + 4 <= n; i += 4) {
+					__m256i al = _mm256_loadu_si256((const __m256i*) (a_lo + i));
+					__m256i ah = _mm256_loadu_si256((const __m256i*) (a_hi + i));
+					__m256i bl = _mm256_loadu_si256((const __m256i*) (b_lo + i));
+					__m256i bh = _mm256_loadu_si256((const __m256i*) (b_hi + i));
+					al = _mm256_blendv_epi8(al, bl, _mm256_cmpgt_epi64(al, bl));
+					ah = _mm256_blendv_epi8(ah, bh, _mm256_cmpgt_epi64(bh, ah));
+					_mm256_storeu_si256((__m256i*) (a_lo + i), al);
+					_mm256_storeu_si256((__m256i*) (a_hi + i), ah);
+				}
+#elif defined(__SSE4_2__)
+				for (; i + 2 <= n; i += 2) {
+					__m128i al = _mm_loadu_si128((const __m128i*) (a_lo + i));
+					__m128i ah = _mm_loadu_si128((const __m128i*) (a_hi + i));
+					__m128i bl = _mm_loadu_si128((const __m128i*) (b_lo + i));
+					__m128i bh = _mm_loadu_si128((const __m128i*) (b_hi + i));
+					al = _mm_blendv_epi8(al, bl, _mm_cmpgt_epi64(al, bl));
+					ah = _mm_blendv_epi8(ah, bh, _mm_cmpgt_epi64(bh, ah));
+					_mm_storeu_si128((__m128i*) (a_lo + i), al);
+					_mm_storeu_si128((__m128i*) (a_hi + i), ah);
+				}
+#endif
+				widen_scalar(a_lo + i, a_hi + i, b_lo + i, b_hi + i, n - i);
+			}
+
+			inline bool all_intersect(const double* a_lo, const double* a_hi,
+			                          const double* b_lo, const double* b_hi,
+			                          std::size_t n, double eps)
+			{
+				std::size_t i = 0;
+#if defined(__AVX__)
+				const __m256d e = _mm256_set1_pd(eps);
+				for (; i + 4 <= n; i += 4) {
+					__m256d al = _mm256_loadu_pd(a_lo + i);
+					__m256d ah = _mm256_loadu_pd(a_hi + i);
+					__m256d bl = _mm256_loadu_pd(b_lo + i);
+					__m256d bh = _mm256_loadu_pd(b_hi + i);
+					__m256d disjoint = _mm256_or_pd(
+						_mm256_cmp_pd(_mm256_add_pd(bh, e), al, _CMP_LT_OQ),
+						_mm256_cmp_pd(_mm256_add_pd(ah, e), bl, _CMP_LT_OQ));
+					if (_mm256_movemask_pd(disjoint))
+						return false;
+				}
+#elif defined(__SSE2__)
+				const __m128d e = _mm_set1_pd(eps);
+				for (; i + 2 <= n; i += 2) {
+					__m128d al = _mm_loadu_pd(a_lo + i);
+					__m128d ah = _mm_loadu_pd(a_hi + i);
+					__m128d bl = _mm_loadu_pd(b_lo + i);
+					__m128d bh = _mm_loadu_pd(b_hi + i);
+					__m128d disjoint = _mm_or_pd(
+						_mm_cmplt_pd(_mm_add_pd(bh, e), al),
+						_mm_cmplt_pd(_mm_add_pd(ah, e), bl));
+					if (_mm_movemask_pd(disjoint))
+						return false;
+				}
+#endif
+				return all_intersect_scalar(a_lo + i, a_hi + i, b_lo + i, b_hi + i,
+				                            n - i, eps);
+			}
+
+			// Note: min(b, a) and max(b, a) return a on ties, like
+			// std::min(a, b) and std::max(a, b).
+			inline void widen(double* a_lo, double* a_hi,
+			                  const double* b_lo, const double* b_hi,
+			                  std::size_t n)
+			{
+				std::size_t i = 0;
+#if defined(__AVX__)
+				for (; i + 4 <= n; i += 4) {
+					__m256d al = _mm256_loadu_pd(a_lo + i);
+					__m256d ah = _mm256_loadu_pd(a_hi + i);
+					_mm256_storeu_pd(a_lo + i, _mm256_min_pd(_mm256_loadu_pd(b_lo + i), al));
+					_mm256_storeu_pd(a_hi + i, _mm256_max_pd(_mm256_loadu_pd(b_hi + i), ah));
+				}
+#elif defined(__SSE2__)
+				for (; i + 2 <= n; i += 2) {
+					__m128d al = _mm_loadu_pd(a_lo + i);
+					__m128d ah = _mm_loadu_pd(a_hi + i);
+					_mm_storeu_pd(a_lo + i, _mm_min_pd(_mm_loadu_pd(b_lo + i), al));
+					_mm_storeu_pd(a_hi + i, _mm_max_pd(_mm_loadu_pd(b_hi + i), ah));
+				}
+#endif
+				widen_scalar(a_lo + i, a_hi + i, b_lo + i, b_hi + i, n - i);
+			}
+		}
+	}
+}
+
+#endif
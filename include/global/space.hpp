@@ -7,6 +7,9 @@
 #include <deque>
 #include <forward_list>
 #include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
 
 #include <iostream>
 #include <ostream>
@@ -15,27 +18,35 @@
 #include "config.h"
 
 #ifdef CONFIG_PARALLEL
-#include "tbb/concurrent_hash_map.h"
 #include "tbb/enumerable_thread_specific.h"
 #include "tbb/parallel_for.h"
 #endif
 
 #include "problem.hpp"
 #include "clock.hpp"
+#include "arena.hpp"
+#include "frontier.hpp"
+#include "time_index.hpp"
+#include "radix_sort.hpp"
+#include "checkpoint.hpp"
 
 #include "global/state.hpp"
+#include "global/state_cache.hpp"
+#include "global/spill.hpp"
 
 namespace NP {
 
 	namespace Global {
 
-		template<class Time> class State_space
+		// If M is nonzero, the state space is specialized for exactly M
+		// processors, which allows the compiler to unroll all per-core loops.
+		template<class Time, unsigned int M = 0> class State_space
 		{
 			public:
 
 			typedef Scheduling_problem<Time> Problem;
 			typedef typename Scheduling_problem<Time>::Workload Workload;
-			typedef Schedule_state<Time> State;
+			typedef Schedule_state<Time, M> State;
 
 			static State_space explore(
 					const Problem& prob,
@@ -44,9 +55,38 @@ namespace NP {
 				// doesn't yet support exploration after deadline miss
 				assert(opts.early_exit);
 
-				auto s = State_space(prob.jobs, prob.dag, prob.num_processors, opts.timeout,
+#if defined(CONFIG_PARALLEL) || defined(CONFIG_COLLECT_SCHEDULE_GRAPH)
+				if (opts.frontier_budget)
+					throw std::invalid_argument(
+						"spilling states requires a sequential build "
+						"that does not collect the schedule graph");
+#endif
+
+#ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
+				if (!opts.checkpoint_file.empty())
+					throw std::invalid_argument(
+						"checkpoints are not supported when collecting "
+						"the schedule graph");
+				if (opts.merge_strategy == Merge_strategy::sorting)
+					throw std::invalid_argument(
+						"merging by sorting is not supported when collecting "
+						"the schedule graph");
+#endif
+
+				auto s = State_space(prob.jobs, prob.resolved_dag, prob.num_processors, opts.timeout,
 				                     opts.max_depth, opts.num_buckets);
 				s.be_naive = opts.be_naive;
+				s.merge_by_sorting = opts.merge_strategy == Merge_strategy::sorting;
+				s.compare_jobs = !opts.trust_fingerprints;
+				s.frontier_budget = opts.frontier_budget;
+				s.spill_directory = opts.spill_directory;
+				s.checkpoint_file = opts.checkpoint_file;
+				s.checkpoint_interval = opts.checkpoint_interval;
+				s.checkpoint_header = Checkpoint::make_header(prob, opts,
+					checkpoint_engine_id);
+				s.resuming = opts.resume && !opts.checkpoint_file.empty()
+				             && Checkpoint::exists(opts.checkpoint_file);
+				s.last_checkpoint = std::chrono::steady_clock::now();
 				s.cpu_time.start();
 				s.explore();
 				s.cpu_time.stop();
@@ -77,7 +117,13 @@ namespace NP {
 
 			Interval<Time> get_finish_times(const Job<Time>& j) const
 			{
-				return Interval<Time>{rta[index_of(j)]};
+				return get_finish_times(index_of(j));
+			}
+
+			// finish times of the job at the given position in the workload
+			Interval<Time> get_finish_times(std::size_t index) const
+			{
+				return Interval<Time>{rta[index]};
 			}
 
 			bool is_schedulable() const
@@ -110,7 +156,18 @@ namespace NP {
 				return cpu_time;
 			}
 
-			typedef std::deque<State> States;
+			// per-worker load statistics (empty in sequential builds)
+			Workers_stats get_worker_stats() const
+			{
+#ifdef CONFIG_PARALLEL
+				return frontier.get_stats();
+#else
+				return Workers_stats();
+#endif
+			}
+
+			// the states of one depth, which are released together
+			typedef Arena_sequence<State> States;
 
 #ifdef CONFIG_PARALLEL
 			typedef tbb::enumerable_thread_specific< States > Split_states;
@@ -180,14 +237,13 @@ namespace NP {
 			typedef typename std::forward_list<State_ref> State_refs;
 
 #ifdef CONFIG_PARALLEL
-			typedef tbb::concurrent_hash_map<hash_value_t, State_refs> States_map;
-			typedef typename States_map::accessor States_map_accessor;
+			typedef State_cache<State> States_map;
 #else
 			typedef std::unordered_map<hash_value_t, State_refs> States_map;
 #endif
 
 			typedef const Job<Time>* Job_ref;
-			typedef std::multimap<Time, Job_ref> By_time_map;
+			typedef Time_index<Time> By_time_index;
 
 			typedef std::deque<State_ref> Todo_queue;
 
@@ -213,20 +269,28 @@ namespace NP {
 
 			bool be_naive;
 
+			// merge the states of a depth only once all of them exist
+			// (see merge_front())
+			bool merge_by_sorting;
+
+			// if false, states with equal fingerprints are merged without
+			// comparing their sets of scheduled jobs
+			bool compare_jobs;
+
 			const Workload& jobs;
 
 			// not touched after initialization
 			Jobs_lut _jobs_by_win;
-			By_time_map _jobs_by_latest_arrival;
-			By_time_map _jobs_by_earliest_arrival;
-			By_time_map _jobs_by_deadline;
+			By_time_index _jobs_by_latest_arrival;
+			By_time_index _jobs_by_earliest_arrival;
+			By_time_index _jobs_by_deadline;
 			std::vector<Job_precedence_set> _predecessors;
 
 			// use these const references to ensure read-only access
 			const Jobs_lut& jobs_by_win;
-			const By_time_map& jobs_by_latest_arrival;
-			const By_time_map& jobs_by_earliest_arrival;
-			const By_time_map& jobs_by_deadline;
+			const By_time_index& jobs_by_latest_arrival;
+			const By_time_index& jobs_by_earliest_arrival;
+			const By_time_index& jobs_by_deadline;
 			const std::vector<Job_precedence_set>& predecessors;
 
 			States_storage states_storage;
@@ -239,54 +303,80 @@ namespace NP {
 
 #ifdef CONFIG_PARALLEL
 			tbb::enumerable_thread_specific<unsigned long> edge_counter;
+			Frontier_scheduler frontier;
+			tbb::enumerable_thread_specific<Successor_draft<Time>> drafts;
+#else
+			Successor_draft<Time> draft;
 #endif
 			Processor_clock cpu_time;
 			const double timeout;
 
 			const unsigned int num_cpus;
 
+			// external-memory mode: at most frontier_budget states of the
+			// next depth are kept in memory, the rest are spilled to runs
+			std::size_t frontier_budget;
+			std::string spill_directory;
+			const Spill_format<Time> spill_format;
+			std::vector<Spill_file> spilled;
+			static const std::size_t max_runs = 64;
+
+			// identifies this analysis in checkpoints
+			static const std::uint32_t checkpoint_engine_id = 0x200;
+
+			std::string checkpoint_file;
+			double checkpoint_interval;
+			Checkpoint::Header checkpoint_header;
+			std::chrono::steady_clock::time_point last_checkpoint;
+			bool resuming;
+
 			State_space(const Workload& jobs,
-			            const Precedence_constraints &dag_edges,
+			            const Resolved_precedence_constraints &dag_edges,
 			            unsigned int num_cpus,
 			            double max_cpu_time = 0,
 			            unsigned int max_depth = 0,
 			            std::size_t num_buckets = 1000)
-			: _jobs_by_win(Interval<Time>{0, max_deadline(jobs)},
-			               max_deadline(jobs) / num_buckets)
-			, jobs(jobs)
+			: rta(Response_times(jobs.size(), {Time_model::constants<Time>::infinity(), 0}))
+#ifdef CONFIG_PARALLEL
+			, partial_rta(Response_times(jobs.size(), {Time_model::constants<Time>::infinity(), 0}))
+#endif
 			, aborted(false)
 			, timed_out(false)
-			, be_naive(false)
-			, timeout(max_cpu_time)
 			, max_depth(max_depth)
-			, num_states(0)
-			, num_edges(0)
-			, width(0)
-			, current_job_count(0)
-			, num_cpus(num_cpus)
+			, be_naive(false)
+			, merge_by_sorting(false)
+			, compare_jobs(true)
+			, jobs(jobs)
+			, _jobs_by_win(Interval<Time>{0, max_deadline(jobs)},
+			               max_deadline(jobs) / num_buckets)
+			, _jobs_by_latest_arrival(jobs, &Job<Time>::latest_arrival)
+			, _jobs_by_earliest_arrival(jobs, &Job<Time>::earliest_arrival)
+			, _jobs_by_deadline(jobs, &Job<Time>::get_deadline)
+			, _predecessors(jobs.size())
+			, jobs_by_win(_jobs_by_win)
 			, jobs_by_latest_arrival(_jobs_by_latest_arrival)
 			, jobs_by_earliest_arrival(_jobs_by_earliest_arrival)
 			, jobs_by_deadline(_jobs_by_deadline)
-			, jobs_by_win(_jobs_by_win)
-			, _predecessors(jobs.size())
 			, predecessors(_predecessors)
-			, rta(Response_times(jobs.size(), {Time_model::constants<Time>::infinity(), 0}))
-#ifdef CONFIG_PARALLEL
-			, partial_rta(Response_times(jobs.size(), {Time_model::constants<Time>::infinity(), 0}))
-#endif
+			, num_states(0)
+			, width(0)
+			, current_job_count(0)
+			, num_edges(0)
+			, timeout(max_cpu_time)
+			, num_cpus(num_cpus)
+			, frontier_budget(0)
+			, spill_format(jobs.size(), num_cpus)
+			, checkpoint_interval(0)
+			, resuming(false)
 			{
+				assert(!M || num_cpus == M);
+
 				for (const Job<Time>& j : jobs) {
-					_jobs_by_latest_arrival.insert({j.latest_arrival(), &j});
-					_jobs_by_earliest_arrival.insert({j.earliest_arrival(), &j});
-					_jobs_by_deadline.insert({j.get_deadline(), &j});
 					_jobs_by_win.insert(j);
 				}
 
-				for (auto e : dag_edges) {
-					const Job<Time>& from = lookup<Time>(jobs, e.first);
-					const Job<Time>& to   = lookup<Time>(jobs, e.second);
-					_predecessors[index_of(to)].push_back(index_of(from));
-				}
+				for (auto e : dag_edges)
+					_predecessors[e.second].push_back(e.first);
 			}
 
 			private:
@@ -373,7 +463,7 @@ namespace NP {
 				// to miss their deadline
 				for (auto it = jobs_by_deadline.lower_bound(check_from);
 				     it != jobs_by_deadline.end(); it++) {
-					const Job<Time>& j = *(it->second);
+					const Job<Time>& j = jobs[it->job];
 					if (j.get_deadline() < earliest) {
 						if (unfinished(new_s, j)) {
 							DM("deadline miss: " << new_s << " -> " << j << std::endl);
@@ -385,7 +475,7 @@ namespace NP {
 							auto frange = new_s.core_availability() + j.get_cost();
 							const State& next =
 								new_state(new_s, index_of(j), predecessors_of(j),
-								          frange, frange, j.get_key());
+								          frange, frange);
 							// update response times
 							update_finish_times(j, frange);
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
@@ -402,9 +492,123 @@ namespace NP {
 
 			void make_initial_state()
 			{
-				// construct initial state
 				states_storage.emplace_back();
-				new_state(num_cpus);
+				if (resuming)
+					resume_from_checkpoint();
+				else
+					// construct initial state
+					new_state(num_cpus, jobs.size());
+			}
+
+			void checkpoint_if_due()
+			{
+				if (checkpoint_file.empty() || aborted)
+					return;
+				auto now = std::chrono::steady_clock::now();
+				if (now - last_checkpoint
+				    < std::chrono::duration<double>(checkpoint_interval))
+					return;
+				write_checkpoint();
+				last_checkpoint = std::chrono::steady_clock::now();
+			}
+
+			// The front is written as the states in memory, followed by the
+			// runs that were spilled to disk, all in the format of
+			// global/spill.hpp.
+			void write_checkpoint()
+			{
+				Checkpoint::Header h = checkpoint_header;
+				h.depth = current_job_count;
+				h.num_states = num_states;
+				h.num_edges = num_edges;
+#ifdef CONFIG_PARALLEL
+				for (auto c : edge_counter)
+					h.num_edges += c;
+#endif
+				h.width = width;
+				h.cpu_time = cpu_time;
+
+				Checkpoint::Writer out(checkpoint_file);
+				out.write_value(h);
+				out.write_finish_times(rta);
+
+				Spill_record rec;
+				auto write_record = [&] () {
+					out.write(rec.data(), rec.size() * sizeof(Spill_word));
+				};
+
+				std::uint64_t n = 0;
+#ifdef CONFIG_PARALLEL
+				for (const States& part : states_storage.back())
+					n += part.size();
+				out.write_value(n);
+				for (const States& part : states_storage.back())
+					for (const State& s : part) {
+						s.spill(spill_format, rec);
+						write_record();
+					}
+#else
+				n = states().size();
+				out.write_value(n);
+				for (const State& s : states()) {
+					s.spill(spill_format, rec);
+					write_record();
+				}
+#endif
+
+				out.write_value(std::uint64_t(spilled.size()));
+				for (Spill_file& run : spilled) {
+					out.write_value(std::uint64_t(run.size()));
+					run.rewind();
+					while (run.read(spill_format, rec))
+						write_record();
+				}
+
+				out.commit();
+			}
+
+			void resume_from_checkpoint()
+			{
+				Checkpoint::Reader in(checkpoint_file);
+				auto h = in.read_header(checkpoint_header);
+				in.read_finish_times(rta);
+
+				current_job_count = h.depth;
+				num_states = h.num_states;
+				num_edges = h.num_edges;
+				width = h.width;
+				cpu_time.add(h.cpu_time);
+
+				Spill_record rec;
+				auto read_record = [&] () {
+					rec.resize(spill_format.prefix_words());
+					in.read(rec.data(), rec.size() * sizeof(Spill_word));
+					auto n = spill_format.record_words(rec.data());
+					rec.resize(n);
+					in.read(rec.data() + spill_format.prefix_words(),
+					        (n - spill_format.prefix_words()) * sizeof(Spill_word));
+				};
+
+				auto n = in.read_value<std::uint64_t>();
+				for (std::uint64_t i = 0; i < n; i++) {
+					read_record();
+					states().emplace_back(spill_format, rec.data());
+				}
+
+				auto num_runs = in.read_value<std::uint64_t>();
+#ifdef CONFIG_PARALLEL
+				if (num_runs)
+					throw std::runtime_error(checkpoint_file + ": spilled "
+						"states require a sequential build");
+#endif
+				for (std::uint64_t i = 0; i < num_runs; i++) {
+					spilled.emplace_back(spill_directory);
+					auto m = in.read_value<std::uint64_t>();
+					for (std::uint64_t j = 0; j < m; j++) {
+						read_record();
+						spilled.back().write(rec);
+					}
+				}
 			}
 
 			States& states()
@@ -419,8 +623,7 @@ namespace NP {
 			template <typename... Args>
 			State_ref alloc_state(Args&&... args)
 			{
-				states().emplace_back(std::forward<Args>(args)...);
-				State_ref s = &(*(--states().end()));
+				State_ref s = &states().emplace_back(std::forward<Args>(args)...);
 
 				// make sure we didn't screw up...
 				auto njobs = s->number_of_scheduled_jobs();
@@ -433,70 +636,57 @@ namespace NP {
 				return s;
 			}
 
-			void dealloc_state(State_ref s)
-			{
-				assert(&(*(--states().end())) == s);
-				states().pop_back();
-			}
-
 			template <typename... Args>
 			State& new_state(Args&&... args)
 			{
 				return *alloc_state(std::forward<Args>(args)...);
 			}
 
-			template <typename... Args>
-			State& new_or_merged_state(Args&&... args)
+			Successor_draft<Time>& successor_draft()
 			{
-				State_ref s_ref = alloc_state(std::forward<Args>(args)...);
-
-				// try to merge the new state into an existing state
-				State_ref s = merge_or_cache(s_ref);
-				if (s != s_ref) {
-					// great, we merged!
-					// clean up the just-created state that we no longer need
-					dealloc_state(s_ref);
-				}
-				return *s;
-			}
-
 #ifdef CONFIG_PARALLEL
+				return drafts.local();
+#else
+				return draft;
+#endif
+			}
 
-			// make state available for fast lookup
-			void insert_cache_state(States_map_accessor &acc, State_ref s)
+			// Schedule job j in state s, merging the successor into an
+			// existing state if possible. The successor is only drafted
+			// until it is clear that it cannot be merged, so that no state
+			// is created (and thrown away again) for successors that merge.
+			State& new_or_merged_state(const State& s, Job_index j,
+			                           const Job_precedence_set& predecessors,
+			                           Interval<Time> start_times,
+			                           Interval<Time> finish_times)
 			{
-				assert(!acc.empty());
+				Successor_draft<Time>& d = successor_draft();
+				s.draft_successor(j, predecessors, start_times, finish_times, d);
 
-				State_refs& list = acc->second;
-				list.push_front(s);
-			}
+#ifdef CONFIG_PARALLEL
+				return *states_by_key.merge_or_create(d.lookup_key,
+					[&] (State_ref other) {
+						return other->try_to_merge(s, d, compare_jobs);
+					},
+					[&] () {
+						return alloc_state(s, d);
+					});
+#else
+				const auto pair_it = states_by_key.find(d.lookup_key);
 
-			// returns true if state was merged
-			State_ref merge_or_cache(State_ref s)
-			{
-				States_map_accessor acc;
-
-				while (true) {
-					// check if key exists
-					if (states_by_key.find(acc, s->get_key())) {
-						for (State_ref other : acc->second)
-							if (other->try_to_merge(*s))
-								return other;
-						// If we reach here, we failed to merge, so go ahead
-						// and insert it.
-						insert_cache_state(acc, s);
-						return s;
-					// otherwise, key doesn't exist yet, let's try to create it
-					} else if (states_by_key.insert(acc, s->get_key())) {
-						// We created the list, so go ahead and insert our state.
-						insert_cache_state(acc, s);
-						return s;
-					}
-					// if we raced with concurrent creation, try again
-				}
+				// cannot merge if key doesn't exist
+				if (pair_it != states_by_key.end())
+					for (State_ref other : pair_it->second)
+						if (other->try_to_merge(s, d, compare_jobs))
+							return *other;
+				// if we reach here, we failed to merge
+				State_ref n = alloc_state(s, d);
+				cache_state(n);
+				return *n;
+#endif
 			}
 
-#else
+#ifndef CONFIG_PARALLEL
 
 			void cache_state(State_ref s)
 			{
@@ -510,22 +700,201 @@ namespace NP {
 				list.push_front(s);
 			}
 
+#endif
 
-			State_ref merge_or_cache(State_ref s_ref)
+			// Sorting merge strategy: the states of the front were created
+			// without looking for merge partners. Sort them by key and
+			// merge each group of states with equal keys in one pass.
+			// Within a group, each state is offered to the surviving
+			// states in the same order in which the hash table would have
+			// offered it (i.e., newest first), so both strategies end up
+			// with the same front. Returns the surviving states in the
+			// order in which they were created.
+			std::vector<State_ref> merge_front()
 			{
-				State& s = *s_ref;
+				std::vector<State_ref> created;
+#ifdef CONFIG_PARALLEL
+				for (States& part : states_storage.back())
+#else
+				States& part = states();
+#endif
+					for (std::size_t i = 0; i < part.size(); i++)
+						created.push_back(&part[i]);
+
+				struct Entry {
+					hash_value_t key;
+					std::size_t index;
+				};
+
+				std::vector<Entry> order(created.size());
+				for (std::size_t i = 0; i < created.size(); i++)
+					order[i] = Entry{created[i]->get_key(), i};
+				radix_sort(order, [] (const Entry& e) { return e.key; });
+
+				// the groups of equal keys
+				std::vector<std::size_t> groups;
+				for (std::size_t i = 0; i < order.size(); i++)
+					if (!i || order[i].key != order[i - 1].key)
+						groups.push_back(i);
+				groups.push_back(order.size());
+
+				std::vector<char> merged(created.size(), false);
+
+				auto merge_groups = [&] (std::size_t from, std::size_t until) {
+					std::vector<State_ref> survivors;
+					for (std::size_t g = from; g < until; g++) {
+						survivors.clear();
+						for (std::size_t i = groups[g]; i < groups[g + 1]; i++) {
+							std::size_t index = order[i].index;
+							State_ref s = created[index];
+							for (auto it = survivors.rbegin(); it != survivors.rend(); it++)
+								if ((*it)->try_to_merge(*s, compare_jobs)) {
+									merged[index] = true;
+									break;
+								}
+							if (!merged[index])
+								survivors.push_back(s);
+						}
+					}
+				};
 
-				const auto pair_it = states_by_key.find(s.get_key());
+				std::size_t num_groups = groups.size() - 1;
+#ifdef CONFIG_PARALLEL
+				tbb::parallel_for(tbb::blocked_range<std::size_t>(0, num_groups),
+					[&] (const tbb::blocked_range<std::size_t>& r) {
+						merge_groups(r.begin(), r.end());
+					});
+#else
+				merge_groups(0, num_groups);
+#endif
 
-				// cannot merge if key doesn't exist
-				if (pair_it != states_by_key.end())
-					for (State_ref other : pair_it->second)
-						if (other->try_to_merge(*s_ref))
-							return other;
-				// if we reach here, we failed to merge
-				cache_state(s_ref);
-				return s_ref;
+				std::vector<State_ref> front;
+				for (std::size_t i = 0; i < created.size(); i++)
+					if (!merged[i])
+						front.push_back(created[i]);
+				return front;
 			}
+
+#ifndef CONFIG_PARALLEL
+
+			void spill_if_over_budget()
+			{
+				if (frontier_budget && states().size() > frontier_budget)
+					spill_states();
+			}
+
+			// Write the states of the next depth as a new sorted run and
+			// drop them from memory. Later states of the same depth can
+			// then no longer merge with them until the runs are read back.
+			void spill_states()
+			{
+				const States& next = states();
+				std::vector<const State*> order;
+				order.reserve(next.size());
+				for (const State& s : next)
+					order.push_back(&s);
+
+				// Sort in the order of Spill_format::less(). Distinct job
+				// sets with the same key are rare, so only they are
+				// compared word by word.
+				Spill_record a, b;
+				std::stable_sort(order.begin(), order.end(),
+					[&] (const State* x, const State* y) {
+						if (x->get_key() != y->get_key())
+							return x->get_key() < y->get_key();
+						if (x->same_jobs_scheduled(*y))
+							return false;
+						x->spill(spill_format, a);
+						y->spill(spill_format, b);
+						return spill_format.less(a.data(), b.data());
+					});
+
+				spilled.emplace_back(spill_directory);
+				for (const State* s : order) {
+					s->spill(spill_format, a);
+					spilled.back().write(a);
+				}
+
+				states().clear();
+				states_by_key.clear();
+
+				if (spilled.size() >= max_runs)
+					compact_runs();
+			}
+
+			// Merge the given runs and pass each group of states with the
+			// same key and jobs to visit(), after merging the states of the
+			// group with each other (unless naive). Stops early if visit()
+			// returns false.
+			template<class Visitor>
+			void merge_runs(std::vector<Spill_file>& runs, Visitor visit)
+			{
+				Spill_merger<Time> merger(spill_format, runs);
+				States group;
+				Spill_record group_key;
+
+				while (const Spill_word* rec = merger.next()) {
+					if (!group.empty()
+					    && !spill_format.same_key_and_jobs(rec, group_key.data())) {
+						if (!visit(group))
+							return;
+						group.clear();
+					}
+					if (group.empty())
+						group_key.assign(rec, rec + spill_format.bitset_words() + 1);
+
+					State& s = group.emplace_back(spill_format, rec);
+					// all states of a group have the same jobs scheduled
+					if (!be_naive)
+						for (std::size_t i = 0; i + 1 < group.size(); i++)
+							if (group[i].try_to_merge(s, false)) {
+								group.pop_back();
+								break;
+							}
+				}
+				if (!group.empty())
+					visit(group);
+			}
+
+			// Replace all runs of the next depth by a single one to bound
+			// the number of open files.
+			void compact_runs()
+			{
+				std::vector<Spill_file> runs;
+				runs.swap(spilled);
+				Spill_file merged(spill_directory);
+				Spill_record rec;
+				merge_runs(runs, [&] (const States& group) {
+					for (const State& s : group) {
+						s.spill(spill_format, rec);
+						merged.write(rec);
+					}
+					return true;
+				});
+				spilled.push_back(std::move(merged));
+			}
+
+			// Explore a depth that was spilled to the given runs. The runs
+			// are merged on the fly, so states with the same key and jobs
+			// arrive together and are merged before they are explored.
+			// Returns the number of states after merging.
+			unsigned long explore_spilled(std::vector<Spill_file>& runs)
+			{
+				unsigned long n = 0;
+				merge_runs(runs, [&] (const States& group) {
+					for (const State& s : group) {
+						n++;
+						explore(s);
+						spill_if_over_budget();
+						check_cpu_timeout();
+						if (aborted)
+							return false;
+					}
+					return true;
+				});
+				return n;
+			}
+
 #endif
 
 			void check_cpu_timeout()
@@ -635,7 +1004,7 @@ namespace NP {
 				for (auto it = jobs_by_latest_arrival
 				               .lower_bound(t_earliest);
 				     it != jobs_by_latest_arrival.end(); it++) {
-					const Job<Time>& j = *(it->second);
+					const Job<Time>& j = jobs[it->job];
 
 					// check if we can stop looking
 					if (when < j.latest_arrival())
@@ -673,7 +1042,7 @@ namespace NP {
 				for (auto it = jobs_by_latest_arrival
 				               .lower_bound(t_earliest);
 				     it != jobs_by_latest_arrival.end(); it++) {
-					const Job<Time>& j = *(it->second);
+					const Job<Time>& j = jobs[it->job];
 
 					// check if we can stop looking
 					if (when < j.latest_arrival())
@@ -729,13 +1098,14 @@ namespace NP {
 				update_finish_times(j, ftimes);
 
 				// expand the graph, merging if possible
-				const State& next = be_naive ?
+				const State& next = (be_naive || merge_by_sorting) ?
 					new_state(s, index_of(j), predecessors_of(j),
-					          st, ftimes, j.get_key()) :
+					          st, ftimes) :
 					new_or_merged_state(s, index_of(j), predecessors_of(j),
-					                    st, ftimes, j.get_key());
+					                    st, ftimes);
 
-				// make sure we didn't skip any jobs
+				// make sure we didn't skip any jobs (when merging by sorting,
+				// this sees the successor before it is merged)
 				check_for_deadline_misses(s, next);
 
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
@@ -781,8 +1151,8 @@ namespace NP {
 				for (auto it = jobs_by_earliest_arrival.upper_bound(t_min);
 					 it != jobs_by_earliest_arrival.end();
 					 it++) {
-					const Job<Time>& j = *it->second;
-					DM(j << " (" << index_of(j) << ")" << std::endl);
+					const Job<Time>& j = jobs[it->job];
+					DM(j << " (" << it->job << ")" << std::endl);
 					// stop looking once we've left the window of interest
 					if (j.earliest_arrival() > t_wc)
 						break;
@@ -816,6 +1186,8 @@ namespace NP {
 				make_initial_state();
 
 				while (current_job_count < jobs.size()) {
+					checkpoint_if_due();
+
 					unsigned long n;
 #ifdef CONFIG_PARALLEL
 					const auto& new_states_part = states_storage.back();
@@ -826,8 +1198,20 @@ namespace NP {
 #else
 					States& exploration_front = states();
 					n = exploration_front.size();
+
+					// if the front was spilled, it is entirely on disk
+					std::vector<Spill_file> runs;
+					runs.swap(spilled);
 #endif
 
+					// with the sorting strategy, the front is merged here
+					bool sorted = merge_by_sorting && !be_naive;
+					std::vector<State_ref> merged_front;
+					if (sorted) {
+						merged_front = merge_front();
+						n = merged_front.size();
+					}
+
 					// allocate states space for next depth
 					states_storage.emplace_back();
 
@@ -843,26 +1227,43 @@ namespace NP {
 
 #ifdef CONFIG_PARALLEL
 
-					parallel_for(new_states_part.range(),
-						[&] (typename Split_states::const_range_type& r) {
-							for (auto it = r.begin(); it != r.end(); it++) {
-								const States& new_states = *it;
-								auto s = new_states.size();
-								tbb::parallel_for(tbb::blocked_range<size_t>(0, s),
-									[&] (const tbb::blocked_range<size_t>& r) {
-										for (size_t i = r.begin(); i != r.end(); i++)
-											explore(new_states[i]);
-								});
-							}
+					if (sorted)
+						frontier.run_range(merged_front.size(), [&] (std::size_t i) {
+							explore(*merged_front[i]);
+						});
+					else
+						frontier.run(new_states_part, [this] (const State& s) {
+							explore(s);
 						});
 
 #else
-					for (const State& s : exploration_front) {
+					auto explore_next = [this] (const State& s) {
 						explore(s);
+						spill_if_over_budget();
 						check_cpu_timeout();
-						if (aborted)
-							break;
+						return !aborted;
+					};
+
+					if (sorted) {
+						for (State_ref s : merged_front)
+							if (!explore_next(*s))
+								break;
+					} else {
+						for (const State& s : exploration_front)
+							if (!explore_next(s))
+								break;
+					}
+
+					if (!runs.empty()) {
+						// spilled states are counted as they are read back
+						n = explore_spilled(runs);
+						width = std::max(width, n);
+						num_states += n;
 					}
+
+					// keep the next depth either in memory or on disk
+					if (!spilled.empty() && !aborted)
+						spill_states();
 #endif
 
 					// clean up the state cache if necessary
@@ -919,17 +1320,17 @@ namespace NP {
 
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
 			friend std::ostream& operator<< (std::ostream& out,
-			                                 const State_space<Time>& space)
+			                                 const State_space& space)
 			{
-					std::map<const Schedule_state<Time>*, unsigned int> state_id;
+					std::map<const State*, unsigned int> state_id;
 					unsigned int i = 0;
 					out << "digraph {" << std::endl;
 #ifdef CONFIG_PARALLEL
 					for (const Split_states& states : space.get_states()) {
-						for (const Schedule_state<Time>& s : tbb::flattened2d<Split_states>(states)) {
+						for (const State& s : tbb::flattened2d<Split_states>(states)) {
 #else
 					for (const auto& front : space.get_states()) {
-						for (const Schedule_state<Time>& s : front) {
+						for (const State& s : front) {
 #endif
 							state_id[&s] = i++;
 							out << "\tS" << state_id[&s]
@@ -974,9 +1375,9 @@ namespace NP {
 
 namespace std
 {
-	template<class Time> struct hash<NP::Global::Schedule_state<Time>>
+	template<class Time, unsigned int M> struct hash<NP::Global::Schedule_state<Time, M>>
     {
-		std::size_t operator()(NP::Global::Schedule_state<Time> const& s) const
+		std::size_t operator()(NP::Global::Schedule_state<Time, M> const& s) const
         {
             return s.get_key();
         }
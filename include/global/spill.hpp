@@ -0,0 +1,359 @@
+#ifndef GLOBAL_SPILL_HPP
+#define GLOBAL_SPILL_HPP
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include "jobs.hpp"
+#include "interval.hpp"
+
+// Spilled states
+// ==============
+//
+// With a frontier budget (see Analysis_options::frontier_budget), the
+// global analysis writes the states of the next depth to run files once
+// it holds too many of them in memory. Each run is a sequence of state
+// records sorted by their lookup key and their set of scheduled jobs,
+// so that the runs of a depth can be merged in one pass and all states
+// that could merge with each other are read back next to each other.
+//
+// A record is a sequence of 64-bit words:
+//
+//     key | scheduled jobs (bitset) | #scheduled | #certain jobs |
+//     earliest core availabilities | latest core availabilities |
+//     certain jobs (index, earliest finish, latest finish)...
+//
+// Run files are private to the process that writes them (they are
+// unlinked right away), so all fields are stored in host byte order.
+
+namespace NP {
+
+	namespace Global {
+
+		typedef std::uint64_t Spill_word;
+		typedef std::vector<Spill_word> Spill_record;
+
+		template<class Time> class Spill_format
+		{
+			static_assert(sizeof(Time) == sizeof(Spill_word),
+			              "spilled states store 64-bit time values");
+
+			public:
+
+			Spill_format(std::size_t num_jobs, unsigned int num_cores)
+			: num_jobs(num_jobs)
+			, num_cores(num_cores)
+			, set_words((num_jobs + 63) / 64)
+			{
+			}
+
+			std::size_t number_of_jobs() const
+			{
+				return num_jobs;
+			}
+
+			unsigned int number_of_cores() const
+			{
+				return num_cores;
+			}
+
+			std::size_t bitset_words() const
+			{
+				return set_words;
+			}
+
+			// the leading part of a record that determines its size
+			std::size_t prefix_words() const
+			{
+				return set_words + 3;
+			}
+
+			std::size_t record_words(std::size_t num_certain) const
+			{
+				return prefix_words() + 2 * num_cores + 3 * num_certain;
+			}
+
+			// size of the record that starts with the given prefix
+			std::size_t record_words(const Spill_word* rec) const
+			{
+				return record_words(number_of_certain_jobs(rec));
+			}
+
+			hash_value_t key(const Spill_word* rec) const
+			{
+				return rec[0];
+			}
+
+			Spill_word* bitset(Spill_word* rec) const
+			{
+				return rec + 1;
+			}
+
+			const Spill_word* bitset(const Spill_word* rec) const
+			{
+				return rec + 1;
+			}
+
+			unsigned int number_of_scheduled_jobs(const Spill_word* rec) const
+			{
+				return rec[set_words + 1];
+			}
+
+			std::size_t number_of_certain_jobs(const Spill_word* rec) const
+			{
+				return rec[set_words + 2];
+			}
+
+			// start a record in rec; the bitset is left to the caller
+			void write_header(Spill_record& rec, hash_value_t key,
+			                  unsigned int num_scheduled, std::size_t num_certain) const
+			{
+				rec.assign(record_words(num_certain), 0);
+				rec[0] = key;
+				rec[set_words + 1] = num_scheduled;
+				rec[set_words + 2] = num_certain;
+			}
+
+			void write_cores(Spill_record& rec, const Time* earliest,
+			                 const Time* latest) const
+			{
+				std::memcpy(&rec[prefix_words()], earliest, num_cores * sizeof(Time));
+				std::memcpy(&rec[prefix_words() + num_cores], latest, num_cores * sizeof(Time));
+			}
+
+			void read_cores(const Spill_word* rec, Time* earliest, Time* latest) const
+			{
+				std::memcpy(earliest, rec + prefix_words(), num_cores * sizeof(Time));
+				std::memcpy(latest, rec + prefix_words() + num_cores, num_cores * sizeof(Time));
+			}
+
+			void write_certain_job(Spill_record& rec, std::size_t i,
+			                       std::size_t job, Interval<Time> finish_times) const
+			{
+				Spill_word* w = &rec[certain_jobs_offset() + 3 * i];
+				Time from = finish_times.from(), until = finish_times.until();
+				w[0] = job;
+				std::memcpy(w + 1, &from, sizeof(Time));
+				std::memcpy(w + 2, &until, sizeof(Time));
+			}
+
+			std::pair<std::size_t, Interval<Time>> certain_job(const Spill_word* rec,
+			                                                   std::size_t i) const
+			{
+				const Spill_word* w = rec + certain_jobs_offset() + 3 * i;
+				Time from, until;
+				std::memcpy(&from, w + 1, sizeof(Time));
+				std::memcpy(&until, w + 2, sizeof(Time));
+				return {std::size_t(w[0]), Interval<Time>{from, until}};
+			}
+
+			// the order of records within a run: by key, then by bitset
+			bool less(const Spill_word* a, const Spill_word* b) const
+			{
+				return std::lexicographical_compare(a, a + set_words + 1,
+				                                    b, b + set_words + 1);
+			}
+
+			// can the states of both records possibly be merged?
+			bool same_key_and_jobs(const Spill_word* a, const Spill_word* b) const
+			{
+				return std::equal(a, a + set_words + 1, b);
+			}
+
+			private:
+
+			std::size_t num_jobs;
+			unsigned int num_cores;
+			std::size_t set_words;
+
+			std::size_t certain_jobs_offset() const
+			{
+				return prefix_words() + 2 * num_cores;
+			}
+		};
+
+		// An anonymous temporary file that holds one run of records. It is
+		// deleted automatically when it is closed.
+		class Spill_file
+		{
+			public:
+
+			// Creates the file in the given directory (or in the system's
+			// temporary directory if none is given). Throws
+			// std::runtime_error if the file cannot be created.
+			explicit Spill_file(const std::string& directory)
+			: file(open(directory))
+			, num_records(0)
+			{
+				std::setvbuf(file, nullptr, _IOFBF, buffer_size);
+			}
+
+			Spill_file(Spill_file&& other) noexcept
+			: file(other.file)
+			, num_records(other.num_records)
+			{
+				other.file = nullptr;
+			}
+
+			~Spill_file()
+			{
+				if (file)
+					std::fclose(file);
+			}
+
+			void write(const Spill_record& rec)
+			{
+				if (std::fwrite(rec.data(), sizeof(Spill_word), rec.size(), file) != rec.size())
+					throw std::runtime_error("could not write spilled states");
+				num_records++;
+			}
+
+			// start reading from the beginning
+			void rewind()
+			{
+				if (std::fflush(file) || std::fseek(file, 0, SEEK_SET))
+					throw std::runtime_error("could not write spilled states");
+			}
+
+			// read the next record into rec; false at the end of the file
+			template<class Time>
+			bool read(const Spill_format<Time>& fmt, Spill_record& rec)
+			{
+				rec.resize(fmt.prefix_words());
+				if (!read_words(rec.data(), rec.size()))
+					return false;
+				auto n = fmt.record_words(rec.data());
+				rec.resize(n);
+				if (!read_words(rec.data() + fmt.prefix_words(), n - fmt.prefix_words()))
+					throw std::runtime_error("truncated spill file");
+				return true;
+			}
+
+			std::size_t size() const
+			{
+				return num_records;
+			}
+
+			private:
+
+			static const std::size_t buffer_size = 1 << 20;
+
+			std::FILE* file;
+			std::size_t num_records;
+
+			bool read_words(Spill_word* out, std::size_t n)
+			{
+				auto got = std::fread(out, sizeof(Spill_word), n, file);
+				if (got != n && std::ferror(file))
+					throw std::runtime_error("could not read spilled states");
+				return got == n;
+			}
+
+			static std::FILE* open(const std::string& directory)
+			{
+				std::FILE* f = nullptr;
+#ifndef _WIN32
+				if (!directory.empty()) {
+					std::string name = directory + "/np-spill-XXXXXX";
+					int fd = mkstemp(&name[0]);
+					if (fd >= 0) {
+						unlink(name.c_str());
+						f = fdopen(fd, "w+b");
+						if (!f)
+							close(fd);
+					}
+				} else
+#endif
+					f = std::tmpfile();
+				if (!f)
+					throw std::runtime_error("could not create spill file in '"
+					                         + (directory.empty() ? std::string("tmp") : directory)
+					                         + "': " + std::strerror(errno));
+				return f;
+			}
+
+			Spill_file(const Spill_file&) = delete;
+		};
+
+		// Merges several sorted runs into one sorted sequence of records.
+		template<class Time> class Spill_merger
+		{
+			public:
+
+			Spill_merger(const Spill_format<Time>& fmt, std::vector<Spill_file>& runs)
+			: fmt(fmt)
+			, runs(runs)
+			, records(runs.size())
+			, current(none)
+			{
+				for (std::size_t i = 0; i < runs.size(); i++) {
+					runs[i].rewind();
+					if (runs[i].read(fmt, records[i]))
+						heap.push_back(i);
+				}
+				std::make_heap(heap.begin(), heap.end(), later());
+			}
+
+			// The next record in order, or null once all runs are exhausted.
+			// The record remains valid until the next call. Equal records
+			// are returned in the order of their runs.
+			const Spill_word* next()
+			{
+				if (current != none && runs[current].read(fmt, records[current])) {
+					heap.push_back(current);
+					std::push_heap(heap.begin(), heap.end(), later());
+				}
+				if (heap.empty()) {
+					current = none;
+					return nullptr;
+				}
+				std::pop_heap(heap.begin(), heap.end(), later());
+				current = heap.back();
+				heap.pop_back();
+				return records[current].data();
+			}
+
+			private:
+
+			static const std::size_t none = ~std::size_t(0);
+
+			const Spill_format<Time>& fmt;
+			std::vector<Spill_file>& runs;
+			std::vector<Spill_record> records;
+			std::vector<std::size_t> heap;
+			std::size_t current;
+
+			// heap order: the smallest record (and the first run) on top
+			struct later_than {
+				const Spill_merger& m;
+
+				bool operator()(std::size_t a, std::size_t b) const
+				{
+					const Spill_word* ra = m.records[a].data();
+					const Spill_word* rb = m.records[b].data();
+					if (m.fmt.less(rb, ra))
+						return true;
+					return !m.fmt.less(ra, rb) && b < a;
+				}
+			};
+
+			later_than later() const
+			{
+				return later_than{*this};
+			}
+		};
+	}
+}
+
+#endif
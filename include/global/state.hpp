@@ -2,11 +2,15 @@
 #include <ostream>
 #include <cassert>
 #include <algorithm>
+#include <array>
 
 #include <set>
 
 #include "util.hpp"
+#include "arena.hpp"
 #include "index_set.hpp"
+#include "global/simd.hpp"
+#include "global/spill.hpp"
 #include "jobs.hpp"
 #include "cache.hpp"
 
@@ -17,18 +21,110 @@ namespace NP {
 		typedef std::size_t Job_index;
 		typedef std::vector<Job_index> Job_precedence_set;
 
-		template<class Time> class Schedule_state
+		// The core availability intervals of a state, kept as two sorted
+		// arrays of the earliest and latest times at which cores become
+		// available. If the number of cores M is known at compile time, both
+		// arrays are stored inline in the state.
+		template<class Time, unsigned int M> class Core_availability
 		{
 			public:
 
+			Core_availability(unsigned int num_cores, const Arena_allocator<char>&)
+			{
+				assert(num_cores == M);
+				(void) num_cores;
+			}
+
+			unsigned int size() const
+			{
+				return M;
+			}
+
+			Time* earliest() { return pa.data(); }
+			Time* latest()   { return ca.data(); }
+			const Time* earliest() const { return pa.data(); }
+			const Time* latest()   const { return ca.data(); }
+
+			private:
+
+			std::array<Time, M> pa, ca;
+
+			// no accidental copies
+			Core_availability(const Core_availability& origin) = delete;
+		};
+
+		// Fallback for a number of cores chosen at runtime (M == 0): both
+		// arrays share one block from the state's allocator, which is
+		// placed right next to the state when states live in an arena.
+		template<class Time> class Core_availability<Time, 0>
+		{
+			public:
+
+			Core_availability(unsigned int num_cores, const Arena_allocator<char>& alloc)
+			: alloc(alloc)
+			, num_cores(num_cores)
+			, times(this->alloc.allocate(2 * num_cores))
+			{
+			}
+
+			~Core_availability()
+			{
+				alloc.deallocate(times, 2 * num_cores);
+			}
+
+			unsigned int size() const
+			{
+				return num_cores;
+			}
+
+			Time* earliest() { return times; }
+			Time* latest()   { return times + num_cores; }
+			const Time* earliest() const { return times; }
+			const Time* latest()   const { return times + num_cores; }
+
+			private:
+
+			Arena_allocator<Time> alloc;
+			const unsigned int num_cores;
+			Time* const times;
+
+			// no accidental copies
+			Core_availability(const Core_availability& origin) = delete;
+		};
+
+		// A successor state that has not been created yet: everything
+		// needed to decide whether it can be merged into an existing state
+		// (see Schedule_state::draft_successor()). Drafts are meant to be
+		// reused, so that their buffers are allocated only once.
+		template<class Time> struct Successor_draft
+		{
+			Job_index job;
+			hash_value_t lookup_key, high_key;
+			std::vector<Time> earliest, latest;
+			std::vector<std::pair<Job_index, Interval<Time>>> certain_jobs;
+		};
+
+		template<class Time, unsigned int M = 0> class Schedule_state
+		{
+			public:
+
+			// All dynamically sized parts of a state are taken from this
+			// allocator (by default, from the heap).
+			typedef Arena_allocator<char> Allocator;
+
 			// initial state -- nothing yet has finished, nothing is running
-			Schedule_state(unsigned int num_processors)
-			: scheduled_jobs()
+			Schedule_state(unsigned int num_processors, std::size_t num_jobs = 0,
+			               const Allocator& alloc = Allocator())
+			: scheduled_jobs(num_jobs, alloc)
 			, num_jobs_scheduled(0)
-			, core_avail{num_processors, Interval<Time>(Time(0), Time(0))}
+			, certain_jobs(alloc)
+			, core_avail(num_processors, alloc)
 			, lookup_key{0x9a9a9a9a9a9a9a9aUL}
+			, high_key{0}
 			{
 				assert(core_avail.size() > 0);
+				std::fill_n(core_avail.earliest(), num_processors, Time(0));
+				std::fill_n(core_avail.latest(), num_processors, Time(0));
 			}
 
 			// transition: new state by scheduling a job in an existing state,
@@ -39,87 +135,91 @@ namespace NP {
 				const Job_precedence_set& predecessors,
 				Interval<Time> start_times,
 				Interval<Time> finish_times,
-				hash_value_t key)
+				const Allocator& alloc = Allocator())
 				: num_jobs_scheduled(from.num_jobs_scheduled + 1)
-				, scheduled_jobs{ from.scheduled_jobs, j }
-				, lookup_key{ from.lookup_key ^ key }
+				, scheduled_jobs{ from.scheduled_jobs, j, alloc }
+				, certain_jobs(alloc)
+				, core_avail(from.core_avail.size(), alloc)
+				, lookup_key{ from.lookup_key ^ job_fingerprint(j) }
+				, high_key{ from.high_key ^ job_fingerprint(j, 1) }
 			{
-				int n_cores = from.core_avail.size();
-				auto est = start_times.min();
-				auto lst = start_times.max();
-				auto eft = finish_times.min();
-				auto lft = finish_times.max();
+				DM("est: " << start_times.min() << std::endl
+					<< "lst: " << start_times.max() << std::endl
+					<< "eft: " << finish_times.min() << std::endl
+					<< "lft: " << finish_times.max() << std::endl);
 
-				DM("est: " << est << std::endl
-					<< "lst: " << lst << std::endl
-					<< "eft: " << eft << std::endl
-					<< "lft: " << lft << std::endl);
+				auto n_prec = from.successor_certain_jobs(j, predecessors, start_times,
+				                                          finish_times, certain_jobs);
+				from.successor_cores(n_prec, start_times, finish_times,
+				                     core_avail.earliest(), core_avail.latest());
 
-				int n_prec = 0;
-				// update scheduled jobs
-				// keep it sorted to make it easier to merge
-				bool added_j = false;
-				for (const auto& rj : from.certain_jobs) {
-					auto x = rj.first;
-					auto x_eft = rj.second.min();
-					auto x_lft = rj.second.max();
-					if (contains(predecessors, x)) {
-						n_prec++; // keep track of the number of predecessors of j that are certainly running
-					}
-					else if (lst <= x_eft) {
-						if (!added_j && rj.first > j) {
-							// right place to add j
-							certain_jobs.emplace_back(j, finish_times);
-							added_j = true;
-						}
-						certain_jobs.emplace_back(rj);
-					}
-				}
-				// if we didn't add it yet, add it at the back
-				if (!added_j)
-					certain_jobs.emplace_back(j, finish_times);
-
-
-				// update the cores availability intervals
-				std::vector<Time> ca, pa;
-
-				ca.reserve(n_cores);
-				pa.reserve(n_cores);
-
-				pa.push_back(eft);
-				ca.push_back(lft);
-
-				// note, we must skip first element in from.core_avail
-				if (n_prec > 1) {
-					// if there are n_prec predecessors running, n_prec cores must be available when j starts
-					for (int i = 1; i < n_prec; i++) {
-						pa.push_back(std::max(est, from.core_avail[i].min()));
-						ca.push_back(std::min(lst, std::max(est, from.core_avail[i].max())));
-					}
+				assert(core_avail.size() > 0);
+				DM("*** new state: constructed " << *this << std::endl);
+			}
 
-					for (int i = n_prec; i < from.core_avail.size(); i++) {
-						pa.push_back(std::max(est, from.core_avail[i].min()));
-						ca.push_back(std::max(est, from.core_avail[i].max()));
-					}
-				}
-				else {
-					for (int i = 1; i < from.core_avail.size(); i++) {
-						pa.push_back(std::max(est, from.core_avail[i].min()));
-						ca.push_back(std::max(est, from.core_avail[i].max()));
-					}
-				}
+			// transition: create the drafted successor of a state
+			Schedule_state(
+				const Schedule_state& from,
+				const Successor_draft<Time>& draft,
+				const Allocator& alloc = Allocator())
+				: num_jobs_scheduled(from.num_jobs_scheduled + 1)
+				, scheduled_jobs{ from.scheduled_jobs, draft.job, alloc }
+				, certain_jobs(draft.certain_jobs.begin(), draft.certain_jobs.end(), alloc)
+				, core_avail(from.core_avail.size(), alloc)
+				, lookup_key{ draft.lookup_key }
+				, high_key{ draft.high_key }
+			{
+				std::copy(draft.earliest.begin(), draft.earliest.end(), core_avail.earliest());
+				std::copy(draft.latest.begin(), draft.latest.end(), core_avail.latest());
+				DM("*** new state: constructed " << *this << std::endl);
+			}
 
-				// sort in non-decreasing order
-				std::sort(pa.begin(), pa.end());
-				std::sort(ca.begin(), ca.end());
+			// Compute the parts of the successor that results from
+			// scheduling job j that matter for merging, without creating
+			// the successor (the arguments are those of the transition).
+			void draft_successor(
+				Job_index j,
+				const Job_precedence_set& predecessors,
+				Interval<Time> start_times,
+				Interval<Time> finish_times,
+				Successor_draft<Time>& draft) const
+			{
+				draft.job = j;
+				draft.lookup_key = lookup_key ^ job_fingerprint(j);
+				draft.high_key = high_key ^ job_fingerprint(j, 1);
+				auto n_prec = successor_certain_jobs(j, predecessors, start_times,
+				                                     finish_times, draft.certain_jobs);
+				draft.earliest.resize(core_avail.size());
+				draft.latest.resize(core_avail.size());
+				successor_cores(n_prec, start_times, finish_times,
+				                draft.earliest.data(), draft.latest.data());
+			}
 
-				for (int i = 0; i < from.core_avail.size(); i++) {
-					DM(i << " -> " << pa[i] << ":" << ca[i] << std::endl);
-					core_avail.emplace_back(pa[i], ca[i]);
-				}
+			// recreate a state from a record written by spill()
+			Schedule_state(const Spill_format<Time>& fmt, const Spill_word* rec,
+			               const Allocator& alloc = Allocator())
+			: num_jobs_scheduled(fmt.number_of_scheduled_jobs(rec))
+			, scheduled_jobs(fmt.number_of_jobs(), fmt.bitset(rec), alloc)
+			, certain_jobs(alloc)
+			, core_avail(fmt.number_of_cores(), alloc)
+			, lookup_key{fmt.key(rec)}
+			, high_key{high_key_of(fmt.bitset(rec), fmt.bitset_words())}
+			{
+				fmt.read_cores(rec, core_avail.earliest(), core_avail.latest());
+				auto n = fmt.number_of_certain_jobs(rec);
+				certain_jobs.reserve(n);
+				for (std::size_t i = 0; i < n; i++)
+					certain_jobs.emplace_back(fmt.certain_job(rec, i));
+			}
 
-				assert(core_avail.size() > 0);
-				DM("*** new state: constructed " << *this << std::endl);
+			// write a flat copy of this state to rec (see global/spill.hpp)
+			void spill(const Spill_format<Time>& fmt, Spill_record& rec) const
+			{
+				fmt.write_header(rec, lookup_key, num_jobs_scheduled, certain_jobs.size());
+				scheduled_jobs.copy_words(fmt.bitset(rec.data()), fmt.bitset_words());
+				fmt.write_cores(rec, core_avail.earliest(), core_avail.latest());
+				for (std::size_t i = 0; i < certain_jobs.size(); i++)
+					fmt.write_certain_job(rec, i, certain_jobs[i].first, certain_jobs[i].second);
 			}
 
 			hash_value_t get_key() const
@@ -132,50 +232,63 @@ namespace NP {
 				return scheduled_jobs == other.scheduled_jobs;
 			}
 
-			bool can_merge_with(const Schedule_state<Time>& other) const
+			// The lookup key and the high key together form a 128-bit
+			// fingerprint of the scheduled jobs. If compare_jobs is false,
+			// states with equal fingerprints are assumed to have the same
+			// jobs scheduled (see Analysis_options::trust_fingerprints).
+			bool can_merge_with(const Schedule_state& other,
+			                    bool compare_jobs = true) const
 			{
 				assert(core_avail.size() == other.core_avail.size());
 
-				if (get_key() != other.get_key())
+				if (get_key() != other.get_key() || high_key != other.high_key)
 					return false;
-				if (!same_jobs_scheduled(other))
+				if (compare_jobs && !same_jobs_scheduled(other))
 					return false;
-				for (int i = 0; i < core_avail.size(); i++)
-					if (!core_avail[i].intersects(other.core_avail[i]))
-						return false;
-				return true;
+				return Simd::all_intersect(
+					core_avail.earliest(), core_avail.latest(),
+					other.core_avail.earliest(), other.core_avail.latest(),
+					core_avail.size(), Time_model::constants<Time>::epsilon());
 			}
 
-			bool try_to_merge(const Schedule_state<Time>& other)
+			bool try_to_merge(const Schedule_state& other, bool compare_jobs = true)
 			{
-				if (!can_merge_with(other))
+				if (!can_merge_with(other, compare_jobs))
 					return false;
 
-				for (int i = 0; i < core_avail.size(); i++)
-					core_avail[i] |= other.core_avail[i];
+				merge(other.core_avail.earliest(), other.core_avail.latest(),
+				      other.certain_jobs);
 
-				// vector to collect joint certain jobs
-				std::vector<std::pair<Job_index, Interval<Time>>> new_cj;
+				DM("+++ merged " << other << " into " << *this << std::endl);
 
-				// walk both sorted job lists to see if we find matches
-				auto it = certain_jobs.begin();
-				auto jt = other.certain_jobs.begin();
-				while (it != certain_jobs.end() &&
-				       jt != other.certain_jobs.end()) {
-					if (it->first == jt->first) {
-						// same job
-						new_cj.emplace_back(it->first, it->second | jt->second);
-						it++;
-						jt++;
-					} else if (it->first < jt->first)
-						it++;
-					else
-						jt++;
-				}
-				// move new certain jobs into the state
-				certain_jobs.swap(new_cj);
+				return true;
+			}
 
-				DM("+++ merged " << other << " into " << *this << std::endl);
+			// Try to merge the drafted successor of the state from into
+			// this state, as if it had been created.
+			bool try_to_merge(const Schedule_state& from,
+			                  const Successor_draft<Time>& draft,
+			                  bool compare_jobs = true)
+			{
+				assert(core_avail.size() == draft.earliest.size());
+
+				if (get_key() != draft.lookup_key || high_key != draft.high_key)
+					return false;
+				// the successor's jobs are those of from plus draft.job
+				if (compare_jobs
+				    && (num_jobs_scheduled != from.num_jobs_scheduled + 1
+				        || !scheduled_jobs.contains(draft.job)
+				        || !from.scheduled_jobs.is_subset_of(scheduled_jobs)))
+					return false;
+				if (!Simd::all_intersect(
+					core_avail.earliest(), core_avail.latest(),
+					draft.earliest.data(), draft.latest.data(),
+					core_avail.size(), Time_model::constants<Time>::epsilon()))
+					return false;
+
+				merge(draft.earliest.data(), draft.latest.data(), draft.certain_jobs);
+
+				DM("+++ merged successor of " << from << " into " << *this << std::endl);
 
 				return true;
 			}
@@ -188,7 +301,7 @@ namespace NP {
 			Interval<Time> core_availability() const
 			{
 				assert(core_avail.size() > 0);
-				return core_avail[0];
+				return core_interval(0);
 			}
 
 			bool get_finish_times(Job_index j, Interval<Time> &ftimes) const
@@ -223,11 +336,12 @@ namespace NP {
 			}
 
 			friend std::ostream& operator<< (std::ostream& stream,
-			                                 const Schedule_state<Time>& s)
+			                                 const Schedule_state& s)
 			{
 				stream << "Global::State(";
-				for (const auto& a : s.core_avail)
-					stream << "[" << a.from() << ", " << a.until() << "] ";
+				for (unsigned int i = 0; i < s.core_avail.size(); i++)
+					stream << "[" << s.core_avail.earliest()[i] << ", "
+					       << s.core_avail.latest()[i] << "] ";
 				stream << "(";
 				for (const auto& rj : s.certain_jobs)
 					stream << rj.first << "";
@@ -239,8 +353,9 @@ namespace NP {
 			void print_vertex_label(std::ostream& out,
 				const typename Job<Time>::Job_set& jobs) const
 			{
-				for (const auto& a : core_avail)
-					out << "[" << a.from() << ", " << a.until() << "] ";
+				for (unsigned int i = 0; i < core_avail.size(); i++)
+					out << "[" << core_avail.earliest()[i] << ", "
+					    << core_avail.latest()[i] << "] ";
 				out << "\\n";
 				bool first = true;
 				out << "{";
@@ -259,16 +374,169 @@ namespace NP {
 
 			const unsigned int num_jobs_scheduled;
 
+			typedef std::pair<Job_index, Interval<Time>> Certain_job;
+
 			// set of jobs that have been dispatched (may still be running)
-			const Index_set scheduled_jobs;
+			const Scheduled_set<Arena_allocator<Index_set::Word>> scheduled_jobs;
 
 			// imprecise set of certainly running jobs
-			std::vector<std::pair<Job_index, Interval<Time>>> certain_jobs;
+			std::vector<Certain_job, Arena_allocator<Certain_job>> certain_jobs;
 
 			// system availability intervals
-			std::vector<Interval<Time>> core_avail;
+			Core_availability<Time, M> core_avail;
 
 			const hash_value_t lookup_key;
+			const hash_value_t high_key;
+
+			// the high key of the jobs in a bitset
+			static hash_value_t high_key_of(const Spill_word* bits, std::size_t num_words)
+			{
+				hash_value_t k = 0;
+				for (std::size_t w = 0; w < num_words; w++)
+					for (std::size_t i = 0; i < 64; i++)
+						if (bits[w] & (Spill_word(1) << i))
+							k ^= job_fingerprint(w * 64 + i, 1);
+				return k;
+			}
+
+			Interval<Time> core_interval(unsigned int i) const
+			{
+				return Interval<Time>{core_avail.earliest()[i], core_avail.latest()[i]};
+			}
+
+			// Widen this state by the given core availabilities and keep
+			// only the certain jobs that it shares with the given ones.
+			template<class Certain_jobs>
+			void merge(const Time* other_pa, const Time* other_ca,
+			           const Certain_jobs& other_certain_jobs)
+			{
+				Simd::widen(core_avail.earliest(), core_avail.latest(),
+				            other_pa, other_ca, core_avail.size());
+
+				// The joint certain jobs are a subset of our own certain
+				// jobs, so we can collect them in place (without allocating).
+				auto out = certain_jobs.begin();
+
+				// walk both sorted job lists to see if we find matches
+				auto it = certain_jobs.begin();
+				auto jt = other_certain_jobs.begin();
+				while (it != certain_jobs.end() &&
+				       jt != other_certain_jobs.end()) {
+					if (it->first == jt->first) {
+						// same job
+						*out++ = std::make_pair(it->first, it->second | jt->second);
+						it++;
+						jt++;
+					} else if (it->first < jt->first)
+						it++;
+					else
+						jt++;
+				}
+				// drop the certain jobs that are not shared
+				certain_jobs.erase(out, certain_jobs.end());
+			}
+
+			// The certain jobs of the successor that results from
+			// scheduling job j (stored in out). Returns the number of
+			// predecessors of j that are certainly running.
+			template<class Certain_jobs>
+			unsigned int successor_certain_jobs(
+				Job_index j,
+				const Job_precedence_set& predecessors,
+				Interval<Time> start_times,
+				Interval<Time> finish_times,
+				Certain_jobs& out) const
+			{
+				auto lst = start_times.max();
+
+				unsigned int n_prec = 0;
+				// update scheduled jobs
+				// keep it sorted to make it easier to merge
+				out.clear();
+				out.reserve(certain_jobs.size() + 1);
+				bool added_j = false;
+				for (const auto& rj : certain_jobs) {
+					auto x = rj.first;
+					auto x_eft = rj.second.min();
+					if (contains(predecessors, x)) {
+						n_prec++; // keep track of the number of predecessors of j that are certainly running
+					}
+					else if (lst <= x_eft) {
+						if (!added_j && rj.first > j) {
+							// right place to add j
+							out.emplace_back(j, finish_times);
+							added_j = true;
+						}
+						out.emplace_back(rj);
+					}
+				}
+				// if we didn't add it yet, add it at the back
+				if (!added_j)
+					out.emplace_back(j, finish_times);
+				return n_prec;
+			}
+
+			// The core availability intervals of the successor that
+			// results from scheduling a job with the given start and finish
+			// times while n_prec of its predecessors are certainly running.
+			void successor_cores(
+				unsigned int n_prec,
+				Interval<Time> start_times,
+				Interval<Time> finish_times,
+				Time* pa, Time* ca) const
+			{
+				unsigned int n_cores = core_avail.size();
+				auto est = start_times.min();
+				auto lst = start_times.max();
+				auto eft = finish_times.min();
+				auto lft = finish_times.max();
+
+				const Time* from_pa = core_avail.earliest();
+				const Time* from_ca = core_avail.latest();
+
+				// Note, we must skip the first core, which is replaced by
+				// the core that j runs on. Since max(est, x) and
+				// min(lst, max(est, x)) are monotonic in x, the remaining
+				// cores stay sorted, and we only need to insert the new
+				// core at the right place.
+				unsigned int k = 0;
+				bool added_eft = false;
+				for (unsigned int i = 1; i < n_cores; i++) {
+					Time t = std::max(est, from_pa[i]);
+					if (!added_eft && eft <= t) {
+						pa[k++] = eft;
+						added_eft = true;
+					}
+					pa[k++] = t;
+				}
+				if (!added_eft)
+					pa[k] = eft;
+
+				k = 0;
+				bool added_lft = false;
+				for (unsigned int i = 1; i < n_cores; i++) {
+					Time t = std::max(est, from_ca[i]);
+					// if there are n_prec predecessors running, n_prec cores
+					// must be available when j starts
+					if (i < n_prec)
+						t = std::min(lst, t);
+					if (!added_lft && lft <= t) {
+						ca[k++] = lft;
+						added_lft = true;
+					}
+					ca[k++] = t;
+				}
+				if (!added_lft)
+					ca[k] = lft;
+
+				// Both sequences are sorted, so taking the per-core minimum
+				// and maximum keeps them sorted.
+				for (unsigned int i = 0; i < n_cores; i++) {
+					if (pa[i] > ca[i])
+						std::swap(pa[i], ca[i]);
+					DM(i << " -> " << pa[i] << ":" << ca[i] << std::endl);
+				}
+			}
 
 			// no accidental copies
 			Schedule_state(const Schedule_state& origin)  = delete;
@@ -0,0 +1,216 @@
+#ifndef GLOBAL_STATE_CACHE_HPP
+#define GLOBAL_STATE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <utility>
+
+#include "jobs.hpp"
+
+namespace NP {
+
+	namespace Global {
+
+		// Concurrent lookup table of the states at the current depth,
+		// keyed by their lookup key. Several states may share a key.
+		//
+		// The table is split into independently locked stripes. Each
+		// stripe is an open-addressing table with linear probing, so that
+		// all states with the same key are found in one contiguous run of
+		// slots. Slots are tagged with the epoch in which they were filled,
+		// which allows clearing the whole table in O(1) by starting a new
+		// epoch.
+		template<class State> class State_cache
+		{
+			public:
+
+			explicit State_cache(std::size_t num_stripes = 1024)
+			: stripes(new Stripe[round_up(num_stripes)])
+			, stripe_mask(round_up(num_stripes) - 1)
+			, epoch(1)
+			{
+			}
+
+			State_cache(State_cache&& origin) = default;
+
+			// Try to merge s into a cached state with the same key. Returns
+			// the state that s was merged into, or s itself if it could not
+			// be merged, in which case s is now cached. The most recently
+			// cached states are tried first. The flag compare_jobs is
+			// passed on to State::try_to_merge().
+			State* merge_or_insert(State* s, bool compare_jobs = true)
+			{
+				return merge_or_create(s->get_key(),
+					[&] (State* cached) {
+						return cached->try_to_merge(*s, compare_jobs);
+					},
+					[s] () { return s; });
+			}
+
+			// Offer a state that is yet to be created to the cached states
+			// with the given key, most recent first, until try_merge(cached)
+			// returns true, and return the state it was merged into. If no
+			// cached state accepts it, cache and return create(). Both are
+			// called while the key's stripe is locked.
+			template<class Try_merge, class Create>
+			State* merge_or_create(hash_value_t key, Try_merge try_merge, Create create)
+			{
+				auto h = mix(key);
+				Stripe& stripe = stripes[(h >> 32) & stripe_mask];
+
+				Lock_guard guard(stripe);
+
+				stripe.sync(epoch);
+
+				auto mask = stripe.slots.size() - 1;
+				auto home = h & mask;
+				auto i = home;
+				for (; stripe.is_live(i); i = (i + 1) & mask) {
+					Slot& slot = stripe.slots[i];
+					if (slot.key == key && try_merge(slot.state))
+						return slot.state;
+				}
+
+				State* s = create();
+
+				// Not merged: insert s in front of all other states with
+				// the same key by shifting them down the run by one slot.
+				State* carry = s;
+				for (auto j = home; j != i; j = (j + 1) & mask)
+					if (stripe.slots[j].key == key)
+						std::swap(carry, stripe.slots[j].state);
+				stripe.slots[i] = Slot{key, carry, epoch};
+
+				if (++stripe.used * 2 > stripe.slots.size())
+					stripe.grow();
+
+				return s;
+			}
+
+			// Forget all cached states. Must not be called concurrently
+			// with merge_or_insert().
+			void clear()
+			{
+				epoch++;
+			}
+
+			private:
+
+			static const std::size_t initial_slots = 16;
+
+			struct Slot {
+				hash_value_t key;
+				State* state;
+				std::size_t epoch;
+			};
+
+			struct Stripe {
+				std::atomic<bool> locked;
+				// epoch of the states in this stripe
+				std::size_t epoch;
+				std::size_t used;
+				std::vector<Slot> slots;
+
+				Stripe()
+				: locked(false)
+				, epoch(0)
+				, used(0)
+				, slots(std::size_t(initial_slots), Slot{0, nullptr, 0})
+				{
+				}
+
+				bool is_live(std::size_t i) const
+				{
+					return slots[i].epoch == epoch;
+				}
+
+				// lazily drop the states of previous epochs
+				void sync(std::size_t current)
+				{
+					if (epoch != current) {
+						epoch = current;
+						used = 0;
+					}
+				}
+
+				void grow()
+				{
+					std::vector<Slot> old(slots.size() * 2, Slot{0, nullptr, 0});
+					old.swap(slots);
+
+					auto mask = slots.size() - 1;
+					auto n = old.size();
+					// Start right after a free slot so that no run is split
+					// and states with the same key keep their order.
+					std::size_t start = 0;
+					while (old[start].epoch == epoch)
+						start++;
+					for (std::size_t k = 1; k <= n; k++) {
+						const Slot& slot = old[(start + k) % n];
+						if (slot.epoch != epoch)
+							continue;
+						auto i = mix(slot.key) & mask;
+						while (is_live(i))
+							i = (i + 1) & mask;
+						slots[i] = slot;
+					}
+				}
+			};
+
+			class Lock_guard
+			{
+				public:
+
+				Lock_guard(Stripe& s)
+				: stripe(s)
+				{
+					while (stripe.locked.exchange(true, std::memory_order_acquire))
+						while (stripe.locked.load(std::memory_order_relaxed))
+							std::this_thread::yield();
+				}
+
+				~Lock_guard()
+				{
+					stripe.locked.store(false, std::memory_order_release);
+				}
+
+				private:
+
+				Stripe& stripe;
+			};
+
+			std::unique_ptr<Stripe[]> stripes;
+			const std::size_t stripe_mask;
+			std::size_t epoch;
+
+			static std::size_t round_up(std::size_t n)
+			{
+				std::size_t p = 1;
+				while (p < n)
+					p <<= 1;
+				return p;
+			}
+
+			// lookup keys are not well distributed, so mix them first
+			static std::uint64_t mix(hash_value_t key)
+			{
+				std::uint64_t h = key;
+				h ^= h >> 33;
+				h *= 0xff51afd7ed558ccdULL;
+				h ^= h >> 33;
+				h *= 0xc4ceb9fe1a85ec53ULL;
+				h ^= h >> 33;
+				return h;
+			}
+
+			// no accidental copies
+			State_cache(const State_cache& origin) = delete;
+		};
+	}
+}
+
+#endif
@@ -1,50 +1,101 @@
 #ifndef INDEX_SET_H
 #define INDEX_SET_H
 
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <memory>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "persistent_index_set.hpp"
+
 namespace NP {
 
-		class Index_set
+		template<class Allocator = std::allocator<std::uint64_t>>
+		class Basic_index_set
 		{
 			public:
 
-			typedef std::vector<bool> Set_type;
+			// the set is packed into 64-bit words
+			typedef std::uint64_t Word;
+			typedef std::vector<Word, Allocator> Set_type;
+
+			static const std::size_t bits_per_word = 64;
 
 			// new empty job set
-			Index_set() : the_set() {}
+			Basic_index_set() : the_set() {}
+
+			// new empty job set with room for indices in [0, num_indices);
+			// all sets derived from it share the same (fixed) capacity
+			explicit Basic_index_set(std::size_t num_indices,
+			                         const Allocator& alloc = Allocator())
+			: the_set(words_needed(num_indices), 0, alloc)
+			{
+			}
 
 			// derive a new set by "cloning" an existing set and adding an index
-			Index_set(const Index_set& from, std::size_t idx)
-			: the_set(std::max(from.the_set.size(), idx + 1))
+			Basic_index_set(const Basic_index_set& from, std::size_t idx,
+			                const Allocator& alloc = Allocator())
+			: the_set(from.the_set, alloc)
+			{
+				add(idx);
+			}
+
+			// recreate a set for indices in [0, num_indices) from the
+			// words written by copy_words()
+			Basic_index_set(std::size_t num_indices, const Word* words,
+			                const Allocator& alloc = Allocator())
+			: the_set(words, words + words_needed(num_indices), alloc)
 			{
-				std::copy(from.the_set.begin(), from.the_set.end(), the_set.begin());
-				the_set[idx] = true;
 			}
 
 			// create the diff of two job sets (intended for debugging only)
-			Index_set(const Index_set &a, const Index_set &b)
-			: the_set(std::max(a.the_set.size(), b.the_set.size()), true)
+			Basic_index_set(const Basic_index_set &a, const Basic_index_set &b)
+			: the_set(std::max(a.the_set.size(), b.the_set.size()), ~Word(0))
 			{
 				auto limit = std::min(a.the_set.size(), b.the_set.size());
-				for (unsigned int i = 0; i < limit; i++)
-					the_set[i] = a.contains(i) ^ b.contains(i);
+				for (std::size_t i = 0; i < limit; i++)
+					the_set[i] = a.the_set[i] ^ b.the_set[i];
 			}
 
-			bool operator==(const Index_set &other) const
+			bool operator==(const Basic_index_set &other) const
 			{
-				return the_set == other.the_set;
+				auto n = the_set.size();
+				// common case: both sets stem from the same analysis
+				if (n == other.the_set.size())
+					return !n || !std::memcmp(the_set.data(),
+					                          other.the_set.data(),
+					                          n * sizeof(Word));
+				// otherwise, the longer set must not have any extra bits
+				const Set_type& shorter = n < other.the_set.size() ? the_set : other.the_set;
+				const Set_type& longer  = n < other.the_set.size() ? other.the_set : the_set;
+				for (std::size_t i = 0; i < shorter.size(); i++)
+					if (shorter[i] != longer[i])
+						return false;
+				for (std::size_t i = shorter.size(); i < longer.size(); i++)
+					if (longer[i])
+						return false;
+				return true;
 			}
 
-			bool operator!=(const Index_set &other) const
+			bool operator!=(const Basic_index_set &other) const
 			{
-				return the_set != other.the_set;
+				return !(*this == other);
 			}
 
 			bool contains(std::size_t idx) const
 			{
-				return the_set.size() > idx && the_set[idx];
+				auto w = idx / bits_per_word;
+				return w < the_set.size()
+				       && (the_set[w] & bit_of(idx));
 			}
 
-			bool includes(std::vector<std::size_t> indices) const
+			bool includes(const std::vector<std::size_t>& indices) const
 			{
 				for (auto i : indices)
 					if (!contains(i))
@@ -52,10 +103,14 @@ namespace NP {
 				return true;
 			}
 
-			bool is_subset_of(const Index_set& other) const
+			bool is_subset_of(const Basic_index_set& other) const
 			{
-				for (unsigned int i = 0; i < the_set.size(); i++)
-					if (contains(i) && !other.contains(i))
+				auto limit = std::min(the_set.size(), other.the_set.size());
+				for (std::size_t i = 0; i < limit; i++)
+					if (the_set[i] & ~other.the_set[i])
+						return false;
+				for (std::size_t i = limit; i < the_set.size(); i++)
+					if (the_set[i])
 						return false;
 				return true;
 			}
@@ -63,26 +118,39 @@ namespace NP {
 			std::size_t size() const
 			{
 				std::size_t count = 0;
-				for (auto x : the_set)
-					if (x)
-						count++;
+				for (auto w : the_set)
+					count += popcount(w);
 				return count;
 			}
 
 			void add(std::size_t idx)
 			{
-				if (idx >= the_set.size())
-					the_set.resize(idx + 1);
-				the_set[idx] = true;
+				auto w = idx / bits_per_word;
+				if (w >= the_set.size())
+					the_set.resize(w + 1, 0);
+				the_set[w] |= bit_of(idx);
+			}
+
+			// write the first num_words words of the bitset to out
+			void copy_words(Word* out, std::size_t num_words) const
+			{
+				auto n = std::min(num_words, the_set.size());
+				std::copy_n(the_set.begin(), n, out);
+				std::fill(out + n, out + num_words, Word(0));
+			}
+
+			static std::size_t words_needed(std::size_t num_indices)
+			{
+				return (num_indices + bits_per_word - 1) / bits_per_word;
 			}
 
 			friend std::ostream& operator<< (std::ostream& stream,
-			                                 const Index_set& s)
+			                                 const Basic_index_set& s)
 			{
 				bool first = true;
 				stream << "{";
-				for (auto i = 0; i < s.the_set.size(); i++)
-					if (s.the_set[i]) {
+				for (std::size_t i = 0; i < s.the_set.size() * bits_per_word; i++)
+					if (s.contains(i)) {
 						if (!first)
 							stream << ", ";
 						first = false;
@@ -97,9 +165,39 @@ namespace NP {
 
 			Set_type the_set;
 
+			static Word bit_of(std::size_t idx)
+			{
+				return Word(1) << (idx % bits_per_word);
+			}
+
+			static std::size_t popcount(Word w)
+			{
+#if defined(__GNUC__) || defined(__clang__)
+				return __builtin_popcountll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+				return __popcnt64(w);
+#else
+				std::size_t count = 0;
+				for (; w; count++)
+					w &= w - 1;
+				return count;
+#endif
+			}
+
 			// no accidental copies
-			Index_set(const Index_set& origin) = delete;
+			Basic_index_set(const Basic_index_set& origin) = delete;
 		};
+
+		typedef Basic_index_set<> Index_set;
+
+		// representation of the set of dispatched jobs in each state
+#ifdef CONFIG_PERSISTENT_JOB_SETS
+		template<class Allocator = std::allocator<Index_set::Word>>
+		using Scheduled_set = Persistent_index_set;
+#else
+		template<class Allocator = std::allocator<Index_set::Word>>
+		using Scheduled_set = Basic_index_set<Allocator>;
+#endif
 }
 
 #endif
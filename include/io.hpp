@@ -2,7 +2,24 @@
 #define IO_HPP
 
 #include <iostream>
+#include <iterator>
 #include <utility>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+#include <exception>
+#include <unordered_map>
+
+#include "config.h"
+
+#ifdef CONFIG_PARALLEL
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+#endif
 
 #include "interval.hpp"
 #include "time.hpp"
@@ -10,6 +27,7 @@
 #include "precedence.hpp"
 #include "aborts.hpp"
 #include "yaml-cpp/yaml.h"
+#include "yaml-cpp/eventhandler.h"
 
 namespace NP {
 
@@ -53,6 +71,279 @@ namespace NP {
 		skip_over(in, '\n');
 	}
 
+	// Parse error of the buffer-based parsers, which know where they are.
+	class Parse_error : public std::ios_base::failure
+	{
+		public:
+
+		Parse_error(unsigned long line, const std::string& what)
+		: std::ios_base::failure("line " + std::to_string(line) + ": " + what)
+		, line(line)
+		{
+		}
+
+		const unsigned long line;
+	};
+
+	// Reads comma-separated numbers directly from a character buffer
+	// (e.g., a memory-mapped file), following the same conventions as
+	// the istream-based parsers: numbers may be preceded by any
+	// whitespace and are separated by a comma and optional spaces.
+	class CSV_reader
+	{
+		public:
+
+		CSV_reader(const char* begin, const char* end, unsigned long first_line = 1)
+		: pos(begin)
+		, end(end)
+		, line(first_line)
+		{
+		}
+
+		bool more_data() const
+		{
+			return pos != end;
+		}
+
+		void next_field()
+		{
+			// eat up any trailing spaces
+			while (pos != end && *pos == ' ')
+				pos++;
+			// eat up field separator
+			if (pos != end && *pos == ',')
+				pos++;
+		}
+
+		void next_line()
+		{
+			auto nl = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+			if (nl) {
+				pos = nl + 1;
+				line++;
+			} else
+				pos = end;
+		}
+
+		// number of (possibly incomplete) lines left in the buffer
+		std::size_t count_lines() const
+		{
+			std::size_t n = 0;
+			const char* p = pos;
+			while (p != end) {
+				auto nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+				n++;
+				p = nl ? nl + 1 : end;
+			}
+			return n;
+		}
+
+		unsigned long current_line() const
+		{
+			return line;
+		}
+
+		const char* position() const
+		{
+			return pos;
+		}
+
+		template<class T> T read()
+		{
+			auto before = line;
+			skip_whitespace();
+			// blame the incomplete row, not the end of the input
+			if (pos == end)
+				throw Parse_error(before, "unexpected end of input");
+			return read<T>(std::is_integral<T>());
+		}
+
+		private:
+
+		const char* pos;
+		const char* const end;
+		unsigned long line;
+
+		// longest accepted floating-point token
+		static const std::size_t max_token = 64;
+
+		void fail(const char* what) const
+		{
+			throw Parse_error(line, what);
+		}
+
+		static bool is_digit(char c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		void skip_whitespace()
+		{
+			for (; pos != end; pos++) {
+				if (*pos == '\n')
+					line++;
+				else if (*pos != ' ' && *pos != '\t' && *pos != '\r'
+				         && *pos != '\v' && *pos != '\f')
+					break;
+			}
+		}
+
+		template<class T> T read(std::true_type)
+		{
+			typedef typename std::make_unsigned<T>::type U;
+
+			// like operator>>, accept a sign also for unsigned types
+			bool negative = false;
+			if (pos != end && (*pos == '-' || *pos == '+'))
+				negative = *pos++ == '-';
+
+			if (pos == end || !is_digit(*pos))
+				fail("expected an integer");
+
+			U limit = std::is_signed<T>::value
+			          ? U(std::numeric_limits<T>::max()) + negative
+			          : std::numeric_limits<U>::max();
+			U value = 0;
+			for (; pos != end && is_digit(*pos); pos++) {
+				unsigned int d = *pos - '0';
+				if (value > (limit - d) / 10)
+					fail("integer out of range");
+				value = value * 10 + d;
+			}
+
+			return negative ? T(U(0) - value) : T(value);
+		}
+
+		template<class T> T read(std::false_type)
+		{
+			// the buffer is not null-terminated, so convert a copy
+			char token[max_token + 1];
+			std::size_t n = 0;
+			for (const char* p = pos; p != end && n < max_token
+			     && (is_digit(*p) || *p == '.' || *p == '-' || *p == '+'
+			         || *p == 'e' || *p == 'E'); p++)
+				token[n++] = *p;
+			token[n] = 0;
+
+			char* parsed;
+			double value = std::strtod(token, &parsed);
+			if (parsed == token)
+				fail("expected a number");
+			pos += parsed - token;
+
+			return T(value);
+		}
+	};
+
+	// Split [begin, end) into n consecutive chunks that end at line
+	// boundaries. Returns the n + 1 chunk boundaries.
+	inline std::vector<const char*> split_lines(const char* begin, const char* end,
+	                                            std::size_t n)
+	{
+		std::vector<const char*> bounds{begin};
+		for (std::size_t k = 1; k < n; k++) {
+			const char* from = std::max(bounds.back(), begin + (end - begin) / n * k);
+			auto nl = static_cast<const char*>(std::memchr(from, '\n', end - from));
+			bounds.push_back(nl ? nl + 1 : end);
+		}
+		bounds.push_back(end);
+		return bounds;
+	}
+
+	// Parse all rows after the header row of the CSV data in [begin,
+	// end), calling parse_row(CSV_reader&) once per row. In parallel
+	// builds, large inputs are split into chunks of whole lines that
+	// are parsed concurrently; the rows are returned in file order, and
+	// errors are reported as if the file had been parsed sequentially.
+	template<class Row, class Parse_row>
+	std::vector<Row> parse_csv_rows(const char* begin, const char* end,
+	                                Parse_row parse_row)
+	{
+		// first row contains a comment, just skip it
+		CSV_reader header(begin, end);
+		header.next_line();
+
+		std::size_t num_chunks = 1;
+#ifdef CONFIG_PARALLEL
+		const std::size_t min_chunk_size = 1 << 20;
+		num_chunks = std::max<std::size_t>(1, std::min<std::size_t>(
+			4 * tbb::this_task_arena::max_concurrency(),
+			(end - header.position()) / min_chunk_size));
+#endif
+		auto bounds = split_lines(header.position(), end, num_chunks);
+
+		std::vector<std::size_t> num_lines(num_chunks);
+		std::vector<std::vector<Row>> rows(num_chunks);
+		std::vector<std::exception_ptr> errors(num_chunks);
+
+		auto count_chunk = [&] (std::size_t i) {
+			num_lines[i] = CSV_reader(bounds[i], bounds[i + 1]).count_lines();
+		};
+
+		auto parse_chunk = [&] (std::size_t i) {
+			unsigned long first_line = header.current_line();
+			for (std::size_t k = 0; k < i; k++)
+				first_line += num_lines[k];
+
+			CSV_reader in(bounds[i], bounds[i + 1], first_line);
+			rows[i].reserve(num_lines[i]);
+			try {
+				while (in.more_data()) {
+					rows[i].push_back(parse_row(in));
+					// munge any trailing whitespace or extra columns
+					in.next_line();
+				}
+			} catch (...) {
+				errors[i] = std::current_exception();
+			}
+		};
+
+#ifdef CONFIG_PARALLEL
+		tbb::parallel_for(std::size_t(0), num_chunks, count_chunk);
+		tbb::parallel_for(std::size_t(0), num_chunks, parse_chunk);
+#else
+		for (std::size_t i = 0; i < num_chunks; i++) {
+			count_chunk(i);
+			parse_chunk(i);
+		}
+#endif
+
+		for (const auto& e : errors)
+			if (e)
+				std::rethrow_exception(e);
+
+		if (num_chunks == 1)
+			return std::move(rows[0]);
+
+		std::size_t total = 0;
+		for (const auto& r : rows)
+			total += r.size();
+
+		std::vector<Row> all;
+		all.reserve(total);
+		for (auto& r : rows)
+			all.insert(all.end(), std::make_move_iterator(r.begin()),
+			           std::make_move_iterator(r.end()));
+		return all;
+	}
+
+	// Read the rest of a stream into a string for the buffer-based parsers.
+	inline std::string read_all(std::istream& in)
+	{
+		if (!in)
+			throw std::ios_base::failure("cannot read input");
+
+		std::ios_base::iostate state_before = in.exceptions();
+		in.exceptions(std::istream::badbit);
+
+		std::string buffer{std::istreambuf_iterator<char>(in),
+		                   std::istreambuf_iterator<char>()};
+
+		in.exceptions(state_before);
+
+		return buffer;
+	}
+
 	inline JobID parse_job_id(std::istream& in)
 	{
 		unsigned long jid, tid;
@@ -81,21 +372,350 @@ namespace NP {
 		return Precedence_constraint(from, to);
 	}
 
-	inline Precedence_constraints parse_dag_file(std::istream& in)
+	inline JobID parse_job_id(CSV_reader& in)
 	{
-		Precedence_constraints edges;
+		unsigned long jid, tid;
 
-		// skip column headers
-		next_line(in);
+		tid = in.read<unsigned long>();
+		in.next_field();
+		jid = in.read<unsigned long>();
+		return JobID(jid, tid);
+	}
 
-		// parse all rows
-		while (more_data(in)) {
+	inline Precedence_constraint parse_precedence_constraint(CSV_reader& in)
+	{
+		// first two columns
+		auto from = parse_job_id(in);
+
+		in.next_field();
+
+		// last two columns
+		auto to = parse_job_id(in);
+
+		return Precedence_constraint(from, to);
+	}
+
+	inline Precedence_constraints parse_dag_file(const char* begin, const char* end)
+	{
+		return parse_csv_rows<Precedence_constraint>(begin, end, [] (CSV_reader& in) {
 			// each row contains one precedence constraint
-			edges.push_back(parse_precedence_constraint(in));
-			next_line(in);
+			return parse_precedence_constraint(in);
+		});
+	}
+
+	inline Precedence_constraints parse_dag_file(std::istream& in)
+	{
+		auto buffer = read_all(in);
+		return parse_dag_file(buffer.data(), buffer.data() + buffer.size());
+	}
+
+	// Event handler that builds the jobs and precedence constraints of a
+	// YAML job set while yaml-cpp parses it, without materializing the
+	// document. The job set is expected under the top-level key "jobset";
+	// everything else is skipped. If jobs is null, only the precedence
+	// constraints are collected.
+	template<class Time>
+	class Yaml_job_set_reader : public YAML::EventHandler
+	{
+		public:
+
+		Yaml_job_set_reader(typename Job<Time>::Job_set* jobs,
+		                    Precedence_constraints& edges)
+		: jobs(jobs)
+		, edges(edges)
+		{
 		}
 
-		return edges;
+		void OnDocumentStart(const YAML::Mark&) override
+		{
+		}
+
+		void OnDocumentEnd() override
+		{
+		}
+
+		void OnNull(const YAML::Mark& mark, YAML::anchor_t) override
+		{
+			scalar(mark, "", true);
+		}
+
+		void OnAlias(const YAML::Mark& mark, YAML::anchor_t anchor) override
+		{
+			auto a = anchors.find(anchor);
+			if (a == anchors.end())
+				throw YAML::RepresentationException(mark,
+					"aliases of collections are not supported");
+			scalar(mark, a->second, false);
+		}
+
+		void OnScalar(const YAML::Mark& mark, const std::string&,
+		              YAML::anchor_t anchor, const std::string& value) override
+		{
+			if (anchor)
+				anchors[anchor] = value;
+			scalar(mark, value, false);
+		}
+
+		void OnSequenceStart(const YAML::Mark& mark, const std::string&,
+		                     YAML::anchor_t, YAML::EmitterStyle::value) override
+		{
+			begin(mark, true);
+		}
+
+		void OnSequenceEnd() override
+		{
+			end();
+		}
+
+		void OnMapStart(const YAML::Mark& mark, const std::string&,
+		                YAML::anchor_t, YAML::EmitterStyle::value) override
+		{
+			begin(mark, false);
+		}
+
+		void OnMapEnd() override
+		{
+			end();
+		}
+
+		private:
+
+		enum Context {
+			root,           // top-level map
+			job_list,       // the sequence under "jobset"
+			job,            // one job
+			successors,     // the successors of a job
+			successor_pair, // compact successor: [Task ID, Job ID]
+			successor_map,  // expanded successor: {Task ID, Job ID}
+			skipped         // anything else
+		};
+
+		struct Level {
+			Context context;
+			// in maps: whether the next scalar is a key, and the last key
+			bool expect_key;
+			std::string key;
+		};
+
+		enum Job_field {
+			task_id, job_id, arrival_min, arrival_max,
+			cost_min, cost_max, deadline, priority,
+			num_job_fields
+		};
+
+		typename Job<Time>::Job_set* jobs;
+		Precedence_constraints& edges;
+		std::vector<Level> levels;
+		std::unordered_map<YAML::anchor_t, std::string> anchors;
+
+		// the job being read
+		YAML::Mark job_mark;
+		Time fields[num_job_fields];
+		unsigned long ids[2];
+		unsigned int seen;
+		std::vector<JobID> job_successors;
+
+		// the successor being read
+		YAML::Mark successor_mark;
+		unsigned long successor[2];
+		unsigned int successor_seen;
+
+		static int job_field(const std::string& key)
+		{
+			static const char* names[num_job_fields] = {
+				"Task ID", "Job ID", "Arrival min", "Arrival max",
+				"Cost min", "Cost max", "Deadline", "Priority"};
+			for (int i = 0; i < num_job_fields; i++)
+				if (key == names[i])
+					return i;
+			return -1;
+		}
+
+		template<class T>
+		static T convert(const YAML::Mark& mark, const std::string& value,
+		                 bool is_null)
+		{
+			// IDs are unsigned, so don't let the reader wrap negative values
+			bool ok = !is_null && !value.empty()
+			          && (std::is_signed<T>::value
+			              || std::is_floating_point<T>::value
+			              || value[0] != '-');
+			T x = T();
+			if (ok) {
+				try {
+					CSV_reader r(value.data(), value.data() + value.size());
+					x = r.read<T>();
+					ok = r.position() == value.data() + value.size();
+				} catch (Parse_error&) {
+					ok = false;
+				}
+			}
+			if (!ok)
+				throw YAML::RepresentationException(mark, "bad conversion of '" + value + "'");
+			return x;
+		}
+
+		void begin(const YAML::Mark& mark, bool is_sequence)
+		{
+			Context c = skipped;
+
+			if (levels.empty())
+				c = is_sequence ? skipped : root;
+			else {
+				Level& parent = levels.back();
+				bool is_value = !parent.expect_key;
+				switch (parent.context) {
+				case root:
+					if (is_value && is_sequence && parent.key == "jobset")
+						c = job_list;
+					break;
+				case job_list:
+					if (is_sequence)
+						throw YAML::RepresentationException(mark, "a job must be a map");
+					c = job;
+					job_mark = mark;
+					seen = 0;
+					job_successors.clear();
+					break;
+				case job:
+					if (is_value && is_sequence && parent.key == "Successors")
+						c = successors;
+					break;
+				case successors:
+					c = is_sequence ? successor_pair : successor_map;
+					successor_mark = mark;
+					successor_seen = 0;
+					break;
+				default:
+					break;
+				}
+				// a collection takes the place of a key or a value
+				if (parent.context == root || parent.context == job
+				    || parent.context == successor_map)
+					parent.expect_key = !parent.expect_key;
+			}
+
+			levels.push_back(Level{c, true, std::string()});
+		}
+
+		void end()
+		{
+			Context c = levels.back().context;
+			levels.pop_back();
+
+			switch (c) {
+			case job:
+				if (jobs && seen != (1u << num_job_fields) - 1)
+					throw YAML::RepresentationException(job_mark, "incomplete job");
+				if (!jobs && !job_successors.empty() && (seen & 3) != 3)
+					throw YAML::RepresentationException(job_mark, "job without ID");
+				if (jobs)
+					jobs->push_back(Job<Time>{ids[1],
+						Interval<Time>{fields[arrival_min], fields[arrival_max]},
+						Interval<Time>{fields[cost_min], fields[cost_max]},
+						fields[deadline], fields[priority], ids[0]});
+				for (const JobID& to : job_successors)
+					edges.push_back(Precedence_constraint(JobID(ids[1], ids[0]), to));
+				break;
+			case successor_pair:
+			case successor_map:
+				if (successor_seen != 3)
+					throw YAML::RepresentationException(successor_mark, "incomplete successor");
+				job_successors.push_back(JobID(successor[1], successor[0]));
+				break;
+			default:
+				break;
+			}
+		}
+
+		void scalar(const YAML::Mark& mark, const std::string& value, bool is_null)
+		{
+			if (levels.empty())
+				return;
+
+			Level& level = levels.back();
+
+			switch (level.context) {
+			case root:
+			case job:
+			case successor_map:
+				if (level.expect_key) {
+					level.key = value;
+					level.expect_key = false;
+					return;
+				}
+				level.expect_key = true;
+				break;
+			case job_list:
+				throw YAML::RepresentationException(mark, "a job must be a map");
+			case successors:
+				throw YAML::RepresentationException(mark, "a successor must be a sequence or a map");
+			default:
+				break;
+			}
+
+			switch (level.context) {
+			case job: {
+				int f = job_field(level.key);
+				if (f == task_id || f == job_id)
+					ids[f] = convert<unsigned long>(mark, value, is_null);
+				else if (f >= 0 && jobs)
+					fields[f] = convert<Time>(mark, value, is_null);
+				if (f >= 0)
+					seen |= 1u << f;
+				break;
+			}
+			case successor_map: {
+				int f = job_field(level.key);
+				if (f == task_id || f == job_id) {
+					successor[f] = convert<unsigned long>(mark, value, is_null);
+					successor_seen |= 1u << f;
+				}
+				break;
+			}
+			case successor_pair:
+				// like the compact form's [0] and [1]; ignore anything else
+				if (successor_seen < 3) {
+					int f = successor_seen ? job_id : task_id;
+					successor[f] = convert<unsigned long>(mark, value, is_null);
+					successor_seen |= 1u << f;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	};
+
+	// Parse the jobs and precedence constraints of a YAML job set in a
+	// single pass over the input. Throws YAML::Exception if the input is
+	// malformed.
+	template<class Time>
+	typename Job<Time>::Job_set read_yaml_job_set(std::istream& in,
+	                                              Precedence_constraints& edges)
+	{
+		typename Job<Time>::Job_set jobs;
+		Yaml_job_set_reader<Time> reader(&jobs, edges);
+		YAML::Parser parser(in);
+		parser.HandleNextDocument(reader);
+		return jobs;
+	}
+
+	// Like read_yaml_job_set(), but like the other YAML parsers, report
+	// errors on std::cerr and return what has been parsed so far.
+	template<class Time>
+	typename Job<Time>::Job_set parse_yaml_job_set(std::istream& in,
+	                                               Precedence_constraints& edges)
+	{
+		typename Job<Time>::Job_set jobs;
+		try {
+			Yaml_job_set_reader<Time> reader(&jobs, edges);
+			YAML::Parser parser(in);
+			parser.HandleNextDocument(reader);
+		} catch (const YAML::Exception& e) {
+			std::cerr << "Error reading YAML file: " << e.what() << std::endl;
+		}
+		return jobs;
 	}
 
 	inline Precedence_constraints parse_yaml_dag_file(std::istream& in)
@@ -106,36 +726,10 @@ namespace NP {
 		// Move the pointer to the beginning
 		in.seekg(0, std::ios::beg);
 		try {
-			// read the YAML file
-			YAML::Node input_job_set = YAML::Load(in);
-			auto const js = input_job_set["jobset"];
-			// Iterate over each jobset entry
-			for (auto const &j : js) {
-				// Check if a job has a successor
-				if (j["Successors"]) {
-					auto from = JobID(j["Job ID"].as<unsigned long>(), j["Task ID"].as<unsigned long>());
-					// Iterate over each successor
-					for (const auto &succ: j["Successors"]) {
-						// first, we need to check to see if it is written
-						// in the compact form [TaskID, JobID]
-						// or the expanded form
-						// - Task ID: Int
-						// 	 Job ID: Int
-						if (succ.IsSequence()) {
-							auto tid = succ[0].as<unsigned long>();
-							auto jid = succ[1].as<unsigned long>();
-							auto to = JobID(jid, tid);
-							edges.push_back(Precedence_constraint(from, to));
-						} else {
-							auto tid = succ["Task ID"].as<unsigned long>();
-							auto jid = succ["Job ID"].as<unsigned long>();
-							auto to = JobID(jid, tid);
-							edges.push_back(Precedence_constraint(from, to));
-						}
-					}
-				}
-			}
-
+			// the job parameters are not needed, so don't convert them
+			Yaml_job_set_reader<dtime_t> reader(nullptr, edges);
+			YAML::Parser parser(in);
+			parser.HandleNextDocument(reader);
 		} catch (const YAML::Exception& e) {
 			std::cerr << "Error reading YAML file: " << e.what() << std::endl;
 		}
@@ -174,51 +768,53 @@ namespace NP {
 						 Interval<Time>{cost_min, cost_max}, dl, prio, tid};
 	}
 
-	template<class Time>
-	typename Job<Time>::Job_set parse_csv_job_file(std::istream& in)
+	template<class Time> Job<Time> parse_job(CSV_reader& in)
 	{
-		// first row contains a comment, just skip it
-		next_line(in);
+		unsigned long tid, jid;
+		Time arr_min, arr_max, cost_min, cost_max, dl, prio;
 
-		typename Job<Time>::Job_set jobs;
+		tid = in.read<unsigned long>();
+		in.next_field();
+		jid = in.read<unsigned long>();
+		in.next_field();
+		arr_min = in.read<Time>();
+		in.next_field();
+		arr_max = in.read<Time>();
+		in.next_field();
+		cost_min = in.read<Time>();
+		in.next_field();
+		cost_max = in.read<Time>();
+		in.next_field();
+		dl = in.read<Time>();
+		in.next_field();
+		prio = in.read<Time>();
 
-		while (more_data(in)) {
-			jobs.push_back(parse_job<Time>(in));
-			// munge any trailing whitespace or extra columns
-			next_line(in);
-		}
+		return Job<Time>{jid, Interval<Time>{arr_min, arr_max},
+						 Interval<Time>{cost_min, cost_max}, dl, prio, tid};
+	}
 
-		return jobs;
+	// Parse a CSV job set from the characters in [begin, end). Errors
+	// are reported as Parse_error with the offending line number.
+	template<class Time>
+	typename Job<Time>::Job_set parse_csv_job_file(const char* begin, const char* end)
+	{
+		return parse_csv_rows<Job<Time>>(begin, end, [] (CSV_reader& in) {
+			return parse_job<Time>(in);
+		});
 	}
 
 	template<class Time>
-	typename Job<Time>::Job_set parse_yaml_job_file(std::istream& in)
+	typename Job<Time>::Job_set parse_csv_job_file(std::istream& in)
 	{
-		typename Job<Time>::Job_set jobs;
-        unsigned long tid, jid;
-        Time arr_min, arr_max, cost_min, cost_max, dl, prio;
-		try {
-			YAML::Node input_job_set = YAML::Load(in);
-
-			auto const js = input_job_set["jobset"];
-			for (auto const &j: js) {
-				tid = j["Task ID"].as<unsigned long>();
-				jid = j["Job ID"].as<unsigned long>();
-				arr_min = j["Arrival min"].as<Time>();
-				arr_max = j["Arrival max"].as<Time>();
-				cost_min = j["Cost min"].as<Time>();
-				cost_max = j["Cost max"].as<Time>();
-				dl = j["Deadline"].as<Time>();
-				prio = j["Priority"].as<Time>();
-
-				jobs.push_back(Job<Time>{jid, Interval<Time>{arr_min, arr_max},
-										 Interval<Time>{cost_min, cost_max}, dl, prio, tid});
-			}
-		} catch (const YAML::Exception& e) {
-			std::cerr << "Error reading YAML file: " << e.what() << std::endl;
-		}
+		auto buffer = read_all(in);
+		return parse_csv_job_file<Time>(buffer.data(), buffer.data() + buffer.size());
+	}
 
-		return jobs;
+	template<class Time>
+	typename Job<Time>::Job_set parse_yaml_job_file(std::istream& in)
+	{
+		Precedence_constraints edges;
+		return parse_yaml_job_set<Time>(in, edges);
 	}
 
 	template<class Time>
@@ -252,20 +848,41 @@ namespace NP {
 
 
 	template<class Time>
-	std::vector<Abort_action<Time>> parse_abort_file(std::istream& in)
+	Abort_action<Time> parse_abort_action(CSV_reader& in)
 	{
-		// first row contains a comment, just skip it
-		next_line(in);
+		unsigned long tid, jid;
+		Time trig_min, trig_max, cleanup_min, cleanup_max;
 
-		std::vector<Abort_action<Time>> abort_actions;
+		tid = in.read<unsigned long>();
+		in.next_field();
+		jid = in.read<unsigned long>();
+		in.next_field();
+		trig_min = in.read<Time>();
+		in.next_field();
+		trig_max = in.read<Time>();
+		in.next_field();
+		cleanup_min = in.read<Time>();
+		in.next_field();
+		cleanup_max = in.read<Time>();
 
-		while (more_data(in)) {
-			abort_actions.push_back(parse_abort_action<Time>(in));
-			// munge any trailing whitespace or extra columns
-			next_line(in);
-		}
+		return Abort_action<Time>{JobID{jid, tid},
+		                          Interval<Time>{trig_min, trig_max},
+		                          Interval<Time>{cleanup_min, cleanup_max}};
+	}
+
+	template<class Time>
+	std::vector<Abort_action<Time>> parse_abort_file(const char* begin, const char* end)
+	{
+		return parse_csv_rows<Abort_action<Time>>(begin, end, [] (CSV_reader& in) {
+			return parse_abort_action<Time>(in);
+		});
+	}
 
-		return abort_actions;
+	template<class Time>
+	std::vector<Abort_action<Time>> parse_abort_file(std::istream& in)
+	{
+		auto buffer = read_all(in);
+		return parse_abort_file<Time>(buffer.data(), buffer.data() + buffer.size());
 	}
 
 
@@ -2,10 +2,12 @@
 #define JOBS_HPP
 
 #include <ostream>
+#include <cstdint>
 #include <vector>
 #include <algorithm> // for find
 #include <functional> // for hash
 #include <exception>
+#include <unordered_map>
 
 #include "time.hpp"
 #include "interval.hpp"
@@ -14,6 +16,23 @@ namespace NP {
 
 	typedef std::size_t hash_value_t;
 
+	// Zobrist-style fingerprints of sets of jobs: the job at each position
+	// in the workload is assigned a pseudo-random value, and a set of jobs
+	// is fingerprinted by the XOR of the values of its members, which is
+	// updated in constant time when a job is added. Unlike the job keys,
+	// which are derived from the jobs' parameters, the values are well
+	// mixed and differ even for jobs with identical parameters. Each job
+	// has a value in each of two independent streams, so that a
+	// fingerprint can be extended to 128 bits.
+	inline hash_value_t job_fingerprint(std::size_t index, unsigned int stream = 0)
+	{
+		// the SplitMix64 sequence
+		std::uint64_t z = (std::uint64_t(index) * 2 + stream + 1) * 0x9e3779b97f4a7c15ULL;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
 	struct JobID {
 		unsigned long job;
 		unsigned long task;
@@ -254,4 +273,45 @@ namespace std {
 	};
 }
 
+namespace NP {
+
+	// Maps job IDs to the positions of the jobs in a job set, so that
+	// references to jobs can be resolved without searching the job set.
+	class Job_id_index
+	{
+		public:
+
+		Job_id_index()
+		{
+		}
+
+		template<class Time>
+		explicit Job_id_index(const std::vector<Job<Time>>& jobs)
+		{
+			positions.reserve(jobs.size());
+			// like lookup(), resolve duplicate IDs to the first job
+			for (std::size_t i = 0; i < jobs.size(); i++)
+				positions.emplace(jobs[i].get_id(), i);
+		}
+
+		bool contains(const JobID& id) const
+		{
+			return positions.find(id) != positions.end();
+		}
+
+		// throws InvalidJobReference if there is no job with the given ID
+		std::size_t position_of(const JobID& id) const
+		{
+			auto pos = positions.find(id);
+			if (pos == positions.end())
+				throw InvalidJobReference(id);
+			return pos->second;
+		}
+
+		private:
+
+		std::unordered_map<JobID, std::size_t> positions;
+	};
+}
+
 #endif
@@ -0,0 +1,95 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <ios>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace NP {
+
+	// Read-only view of the contents of a file. The file is mapped into
+	// memory where possible; otherwise (e.g., under Windows, or for
+	// special files that cannot be mapped) it is read into a buffer.
+	class Mapped_file
+	{
+		public:
+
+		explicit Mapped_file(const std::string& fname)
+		: data(nullptr)
+		, length(0)
+		, mapped(false)
+		{
+#ifndef _WIN32
+			int fd = open(fname.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw std::ios_base::failure("cannot open " + fname);
+
+			struct stat st;
+			if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+				void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED) {
+					madvise(p, st.st_size, MADV_SEQUENTIAL);
+					data = static_cast<const char*>(p);
+					length = st.st_size;
+					mapped = true;
+				}
+			}
+			close(fd);
+
+			if (mapped)
+				return;
+#endif
+			auto in = std::ifstream(fname, std::ios::in | std::ios::binary);
+			if (!in)
+				throw std::ios_base::failure("cannot open " + fname);
+			buffer.assign(std::istreambuf_iterator<char>(in),
+			              std::istreambuf_iterator<char>());
+			data = buffer.data();
+			length = buffer.size();
+		}
+
+		~Mapped_file()
+		{
+#ifndef _WIN32
+			if (mapped)
+				munmap(const_cast<char*>(data), length);
+#endif
+		}
+
+		const char* begin() const
+		{
+			return data;
+		}
+
+		const char* end() const
+		{
+			return data + length;
+		}
+
+		std::size_t size() const
+		{
+			return length;
+		}
+
+		private:
+
+		const char* data;
+		std::size_t length;
+		bool mapped;
+		std::string buffer;
+
+		// no accidental copies
+		Mapped_file(const Mapped_file& origin) = delete;
+		Mapped_file& operator=(const Mapped_file& origin) = delete;
+	};
+}
+
+#endif
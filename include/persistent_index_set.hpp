@@ -0,0 +1,548 @@
+#ifndef PERSISTENT_INDEX_SET_H
+#define PERSISTENT_INDEX_SET_H
+
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+#include <cassert>
+
+namespace NP {
+
+		// An immutable, structurally shared set of indices.
+		//
+		// The set is a bit-trie: leaves hold a chunk of the bitset, inner
+		// nodes hold a fixed number of children, and all-zero subtrees are
+		// represented by null pointers. Deriving a new set by adding an
+		// index copies only the path from the root to the affected leaf;
+		// all other chunks are shared with the original set.
+		//
+		// All nodes are hash-consed (interned): two sets with the same
+		// contents and height share the same root node, so equality is a
+		// single pointer comparison. Nodes are reference-counted and leave
+		// the intern table once the last set referring to them is gone.
+		class Persistent_index_set
+		{
+			public:
+
+			typedef std::uint64_t Word;
+
+			static const std::size_t bits_per_word = 64;
+			static const std::size_t leaf_words = 8;
+			static const std::size_t leaf_bits = leaf_words * bits_per_word;
+			static const std::size_t fanout_shift = 3;
+			static const std::size_t fanout = 1 << fanout_shift;
+
+			// new empty job set
+			Persistent_index_set()
+			: root(nullptr)
+			, height(0)
+			{
+			}
+
+			// new empty job set with room for indices in [0, num_indices)
+			explicit Persistent_index_set(std::size_t num_indices)
+			: root(nullptr)
+			, height(height_needed(num_indices))
+			{
+			}
+
+			// derive a new set by "cloning" an existing set and adding an index
+			Persistent_index_set(const Persistent_index_set& from, std::size_t idx)
+			: root(acquire(from.root))
+			, height(from.height)
+			{
+				add(idx);
+			}
+
+			// recreate a set for indices in [0, num_indices) from the
+			// words written by copy_words()
+			Persistent_index_set(std::size_t num_indices, const Word* words)
+			: root(nullptr)
+			, height(height_needed(num_indices))
+			{
+				root = from_words(words, words_needed(num_indices), height, 0);
+			}
+
+			// Allocator-extended variants for drop-in compatibility with
+			// Basic_index_set. The allocator is ignored: all nodes live in
+			// the shared node pool.
+			template<class Allocator>
+			Persistent_index_set(std::size_t num_indices, const Allocator&)
+			: Persistent_index_set(num_indices)
+			{
+			}
+
+			template<class Allocator>
+			Persistent_index_set(const Persistent_index_set& from, std::size_t idx,
+			                     const Allocator&)
+			: Persistent_index_set(from, idx)
+			{
+			}
+
+			template<class Allocator>
+			Persistent_index_set(std::size_t num_indices, const Word* words,
+			                     const Allocator&)
+			: Persistent_index_set(num_indices, words)
+			{
+			}
+
+			// create the diff of two job sets (intended for debugging only)
+			Persistent_index_set(const Persistent_index_set& a,
+			                     const Persistent_index_set& b)
+			: root(nullptr)
+			, height(0)
+			{
+				auto limit = std::max(a.capacity(), b.capacity());
+				for (std::size_t i = 0; i < limit; i++)
+					if (a.contains(i) ^ b.contains(i))
+						add(i);
+			}
+
+			~Persistent_index_set()
+			{
+				release(root);
+			}
+
+			bool operator==(const Persistent_index_set &other) const
+			{
+				// common case: both sets stem from the same analysis
+				if (height == other.height)
+					return root == other.root;
+				const Persistent_index_set& lower  = height < other.height ? *this : other;
+				const Persistent_index_set& higher = height < other.height ? other : *this;
+				const Node* n = higher.root;
+				for (auto h = higher.height; h > lower.height && n; h--) {
+					for (std::size_t i = 1; i < fanout; i++)
+						if (n->children[i])
+							return false;
+					n = n->children[0];
+				}
+				return n == lower.root;
+			}
+
+			bool operator!=(const Persistent_index_set &other) const
+			{
+				return !(*this == other);
+			}
+
+			bool contains(std::size_t idx) const
+			{
+				if (idx >= capacity())
+					return false;
+				const Node* n = root;
+				for (auto h = height; h > 0 && n; h--)
+					n = n->children[slot_of(idx, h)];
+				return n && (n->words[(idx % leaf_bits) / bits_per_word]
+				             & bit_of(idx));
+			}
+
+			bool includes(const std::vector<std::size_t>& indices) const
+			{
+				for (auto i : indices)
+					if (!contains(i))
+						return false;
+				return true;
+			}
+
+			bool is_subset_of(const Persistent_index_set& other) const
+			{
+				const Node* a = root;
+				const Node* b = other.root;
+				// bring both tries to the same height
+				for (auto h = height; h > other.height && a; h--) {
+					for (std::size_t i = 1; i < fanout; i++)
+						if (a->children[i])
+							return false;
+					a = a->children[0];
+				}
+				for (auto h = other.height; h > height && b; h--)
+					b = b->children[0];
+				return subset(a, b);
+			}
+
+			std::size_t size() const
+			{
+				return root ? root->count : 0;
+			}
+
+			void add(std::size_t idx)
+			{
+				if (contains(idx))
+					return;
+				grow_to(idx + 1);
+				Node* n = with_index(root, height, idx);
+				release(root);
+				root = n;
+			}
+
+			// write the first num_words words of the bitset to out
+			void copy_words(Word* out, std::size_t num_words) const
+			{
+				std::fill_n(out, num_words, Word(0));
+				to_words(root, height, 0, out, num_words);
+			}
+
+			static std::size_t words_needed(std::size_t num_indices)
+			{
+				return (num_indices + bits_per_word - 1) / bits_per_word;
+			}
+
+			friend std::ostream& operator<< (std::ostream& stream,
+			                                 const Persistent_index_set& s)
+			{
+				bool first = true;
+				stream << "{";
+				for (std::size_t i = 0; i < s.capacity(); i++)
+					if (s.contains(i)) {
+						if (!first)
+							stream << ", ";
+						first = false;
+						stream << i;
+					}
+				stream << "}";
+
+				return stream;
+			}
+
+			private:
+
+			struct Node {
+				// next node in the same bucket of the intern table
+				Node* next;
+				std::size_t hash;
+				std::atomic<std::uint32_t> refs;
+				// number of indices contained in this subtree
+				std::uint32_t count;
+				bool leaf;
+				union {
+					Word words[leaf_words];
+					Node* children[fanout];
+				};
+
+				Node()
+				: next(nullptr)
+				, hash(0)
+				, refs(0)
+				, count(0)
+				, leaf(true)
+				{
+					std::memset(words, 0, sizeof(words));
+				}
+
+				bool same_contents(const Node& other) const
+				{
+					return leaf == other.leaf
+					       && (leaf ? !std::memcmp(words, other.words, sizeof(words))
+					                : !std::memcmp(children, other.children, sizeof(children)));
+				}
+			};
+
+			static_assert(sizeof(Word) * leaf_words == sizeof(Node*) * fanout,
+			              "leaves and inner nodes must have the same payload size");
+
+			// Process-wide table of all live nodes. It is split into
+			// independently locked stripes so that analyses running in
+			// parallel rarely contend on the same lock.
+			class Node_pool
+			{
+				public:
+
+				// Returns a referenced node with the same contents as
+				// proto, creating it if necessary.
+				Node* intern(const Node& proto)
+				{
+					Stripe& s = stripe_of(proto.hash);
+					std::lock_guard<std::mutex> guard(s.lock);
+
+					Node*& head = s.buckets[proto.hash & (s.buckets.size() - 1)];
+					for (Node* n = head; n; n = n->next)
+						if (n->hash == proto.hash && n->same_contents(proto)) {
+							n->refs++;
+							return n;
+						}
+
+					Node* n = new Node();
+					n->hash = proto.hash;
+					n->count = proto.count;
+					n->leaf = proto.leaf;
+					std::memcpy(n->words, proto.words, sizeof(n->words));
+					if (!n->leaf)
+						for (Node* c : n->children)
+							acquire(c);
+					n->refs = 1;
+					n->next = head;
+					head = n;
+					if (++s.num_nodes > s.buckets.size())
+						rehash(s);
+					return n;
+				}
+
+				// Drops the node from the table if it is (still) unreferenced.
+				// Returns true if the caller is now responsible for freeing it.
+				bool retire(Node* n, std::size_t hash)
+				{
+					Stripe& s = stripe_of(hash);
+					std::lock_guard<std::mutex> guard(s.lock);
+
+					// Look for the pointer without touching the node: it may
+					// already have been freed by a concurrent release.
+					Node** link = &s.buckets[hash & (s.buckets.size() - 1)];
+					while (*link && *link != n)
+						link = &(*link)->next;
+					if (!*link || n->refs.load() != 0)
+						return false;
+					*link = n->next;
+					s.num_nodes--;
+					return true;
+				}
+
+				static Node_pool& get()
+				{
+					// never destroyed, nodes may outlive static destructors
+					static Node_pool* pool = new Node_pool();
+					return *pool;
+				}
+
+				private:
+
+				static const std::size_t num_stripes = 64;
+				static const std::size_t initial_buckets = 64;
+
+				struct Stripe {
+					std::mutex lock;
+					std::vector<Node*> buckets;
+					std::size_t num_nodes;
+
+					Stripe()
+					: buckets(std::size_t(initial_buckets), nullptr)
+					, num_nodes(0)
+					{
+					}
+				};
+
+				Stripe stripes[num_stripes];
+
+				Stripe& stripe_of(std::size_t hash)
+				{
+					// buckets are selected by the low bits, stripes by the high bits
+					return stripes[(hash >> 58) % num_stripes];
+				}
+
+				static void rehash(Stripe& s)
+				{
+					std::vector<Node*> buckets(s.buckets.size() * 2, nullptr);
+					for (Node* n : s.buckets)
+						while (n) {
+							Node* next = n->next;
+							Node*& head = buckets[n->hash & (buckets.size() - 1)];
+							n->next = head;
+							head = n;
+							n = next;
+						}
+					s.buckets.swap(buckets);
+				}
+			};
+
+			Node* root;
+			unsigned int height;
+
+			static std::size_t height_needed(std::size_t num_indices)
+			{
+				std::size_t h = 0;
+				for (std::size_t cap = leaf_bits; cap < num_indices; cap <<= fanout_shift)
+					h++;
+				return h;
+			}
+
+			std::size_t capacity() const
+			{
+				return leaf_bits << (fanout_shift * height);
+			}
+
+			static std::size_t slot_of(std::size_t idx, unsigned int level)
+			{
+				return ((idx / leaf_bits) >> (fanout_shift * (level - 1))) & (fanout - 1);
+			}
+
+			static Word bit_of(std::size_t idx)
+			{
+				return Word(1) << (idx % bits_per_word);
+			}
+
+			static std::size_t mix(std::size_t h, std::uint64_t x)
+			{
+				h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+				return h;
+			}
+
+			static void seal(Node& proto)
+			{
+				std::size_t h = proto.leaf ? 0x5bd1e995 : 0x27d4eb2f;
+				proto.count = 0;
+				for (std::size_t i = 0; i < leaf_words; i++) {
+					if (proto.leaf) {
+						h = mix(h, proto.words[i]);
+						proto.count += popcount(proto.words[i]);
+					} else {
+						h = mix(h, reinterpret_cast<std::uintptr_t>(proto.children[i]));
+						if (proto.children[i])
+							proto.count += proto.children[i]->count;
+					}
+				}
+				// final avalanche so that the high bits select stripes well
+				h ^= h >> 33;
+				h *= 0xff51afd7ed558ccdULL;
+				h ^= h >> 33;
+				proto.hash = h;
+			}
+
+			static Node* acquire(Node* n)
+			{
+				if (n)
+					n->refs++;
+				return n;
+			}
+
+			static void release(Node* n)
+			{
+				if (!n)
+					return;
+				auto hash = n->hash;
+				if (n->refs.fetch_sub(1) == 1
+				    && Node_pool::get().retire(n, hash)) {
+					if (!n->leaf)
+						for (Node* c : n->children)
+							release(c);
+					delete n;
+				}
+			}
+
+			// add levels on top until idx fits
+			void grow_to(std::size_t num_indices)
+			{
+				while (capacity() < num_indices) {
+					if (root) {
+						Node proto;
+						proto.leaf = false;
+						proto.children[0] = root;
+						seal(proto);
+						Node* n = Node_pool::get().intern(proto);
+						release(root);
+						root = n;
+					}
+					height++;
+				}
+			}
+
+			// returns a referenced node for the subtree n (at given level)
+			// with idx added
+			static Node* with_index(const Node* n, unsigned int level, std::size_t idx)
+			{
+				Node proto;
+				if (!level) {
+					if (n)
+						std::memcpy(proto.words, n->words, sizeof(proto.words));
+					proto.words[(idx % leaf_bits) / bits_per_word] |= bit_of(idx);
+					seal(proto);
+					return Node_pool::get().intern(proto);
+				}
+				auto slot = slot_of(idx, level);
+				proto.leaf = false;
+				if (n)
+					std::memcpy(proto.children, n->children, sizeof(proto.children));
+				Node* child = with_index(proto.children[slot], level - 1, idx);
+				proto.children[slot] = child;
+				seal(proto);
+				Node* res = Node_pool::get().intern(proto);
+				// the new node holds its own reference to the child
+				release(child);
+				return res;
+			}
+
+			// number of words covered by a subtree at the given level
+			static std::size_t words_below(unsigned int level)
+			{
+				return leaf_words << (fanout_shift * level);
+			}
+
+			static void to_words(const Node* n, unsigned int level,
+			                     std::size_t first, Word* out, std::size_t num_words)
+			{
+				if (!n || first >= num_words)
+					return;
+				for (std::size_t i = 0; i < fanout; i++)
+					if (!level) {
+						if (first + i < num_words)
+							out[first + i] = n->words[i];
+					} else
+						to_words(n->children[i], level - 1,
+						         first + i * words_below(level - 1), out, num_words);
+			}
+
+			// returns a referenced node (or null if all words are zero) for
+			// the subtree at the given level that starts at word first
+			static Node* from_words(const Word* words, std::size_t num_words,
+			                        unsigned int level, std::size_t first)
+			{
+				Node proto;
+				bool empty = true;
+				if (!level) {
+					for (std::size_t i = 0; i < leaf_words && first + i < num_words; i++) {
+						proto.words[i] = words[first + i];
+						empty &= !proto.words[i];
+					}
+				} else {
+					proto.leaf = false;
+					for (std::size_t i = 0; i < fanout; i++) {
+						auto start = first + i * words_below(level - 1);
+						if (start < num_words)
+							proto.children[i] = from_words(words, num_words, level - 1, start);
+						empty &= !proto.children[i];
+					}
+				}
+				if (empty)
+					return nullptr;
+				seal(proto);
+				Node* res = Node_pool::get().intern(proto);
+				// the new node holds its own references to the children
+				if (!proto.leaf)
+					for (Node* c : proto.children)
+						release(c);
+				return res;
+			}
+
+			static bool subset(const Node* a, const Node* b)
+			{
+				if (a == b || !a)
+					return true;
+				if (!b || a->count > b->count)
+					return false;
+				for (std::size_t i = 0; i < leaf_words; i++)
+					if (a->leaf ? (a->words[i] & ~b->words[i]) != 0
+					            : !subset(a->children[i], b->children[i]))
+						return false;
+				return true;
+			}
+
+			static std::size_t popcount(Word w)
+			{
+#if defined(__GNUC__) || defined(__clang__)
+				return __builtin_popcountll(w);
+#else
+				std::size_t count = 0;
+				for (; w; count++)
+					w &= w - 1;
+				return count;
+#endif
+			}
+
+			// no accidental copies
+			Persistent_index_set(const Persistent_index_set& origin) = delete;
+		};
+}
+
+#endif
@@ -8,13 +8,30 @@ namespace NP {
 	typedef std::pair<JobID, JobID> Precedence_constraint;
 	typedef std::vector<Precedence_constraint> Precedence_constraints;
 
+	// a precedence constraint between the jobs at the given positions
+	typedef std::pair<std::size_t, std::size_t> Resolved_precedence_constraint;
+	typedef std::vector<Resolved_precedence_constraint> Resolved_precedence_constraints;
+
+	inline Resolved_precedence_constraints resolve_prec_refs(
+		const Precedence_constraints& dag,
+		const Job_id_index& index)
+	{
+		Resolved_precedence_constraints resolved;
+		resolved.reserve(dag.size());
+		for (const auto& constraint : dag)
+			resolved.emplace_back(index.position_of(constraint.first),
+			                      index.position_of(constraint.second));
+		return resolved;
+	}
+
 	template<class Time>
 	void validate_prec_refs(const Precedence_constraints& dag,
-	                        const typename Job<Time>::Job_set jobs)
+	                        const typename Job<Time>::Job_set& jobs)
 	{
-		for (auto constraint : dag) {
-			lookup<Time>(jobs, constraint.first);
-			lookup<Time>(jobs, constraint.second);
+		Job_id_index index(jobs);
+		for (const auto& constraint : dag) {
+			index.position_of(constraint.first);
+			index.position_of(constraint.second);
 		}
 	}
 
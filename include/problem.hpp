@@ -1,6 +1,10 @@
 #ifndef NP_PROBLEM_HPP
 #define NP_PROBLEM_HPP
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "jobs.hpp"
 #include "precedence.hpp"
 #include "aborts.hpp"
@@ -14,54 +18,71 @@ namespace NP {
 		typedef typename Job<Time>::Job_set Workload;
 		typedef typename std::vector<Abort_action<Time>> Abort_actions;
 
-		// ** Description of the workload:
+		// ** Description of the workload (fixed once the problem is
+		// created, since the analyses rely on the derived data below):
 		// (1) a set of jobs
-		Workload jobs;
+		const Workload jobs;
 		// (2) a set of precedence constraints among the jobs
-		Precedence_constraints dag;
+		const Precedence_constraints dag;
 		// (3) abort actions for (some of) the jobs
-		Abort_actions aborts;
+		const Abort_actions aborts;
 
 		// ** Platform model:
 		// on how many (identical) processors are the jobs being
 		// dispatched (globally, in priority order)
 		unsigned int num_processors;
 
+		// ** Derived from the workload when the problem is created, so
+		// that the analyses need not search the job set:
+		// (1) the position of each job in jobs, by job ID
+		const Job_id_index job_index;
+		// (2) the precedence constraints as pairs of job positions
+		const Resolved_precedence_constraints resolved_dag;
+		// (3) the position of the job of each abort action
+		const std::vector<std::size_t> abort_job_positions;
+
 		// Classic default setup: no abort actions
 		Scheduling_problem(Workload jobs, Precedence_constraints dag,
 		                   unsigned int num_processors = 1)
-		: num_processors(num_processors)
-		, jobs(jobs)
-		, dag(dag)
+		: Scheduling_problem(std::move(jobs), std::move(dag),
+		                     Abort_actions(), num_processors)
 		{
-			assert(num_processors > 0);
-			validate_prec_refs<Time>(dag, jobs);
 		}
 
 		// Full constructor with abort actions
+		// (throws InvalidJobReference or InvalidAbortParameter)
 		Scheduling_problem(Workload jobs, Precedence_constraints dag,
 		                   Abort_actions aborts,
 		                   unsigned int num_processors)
-		: num_processors(num_processors)
-		, jobs(jobs)
-		, dag(dag)
-		, aborts(aborts)
+		: jobs(std::move(jobs))
+		, dag(std::move(dag))
+		, aborts(std::move(aborts))
+		, num_processors(num_processors)
+		, job_index(this->jobs)
+		, resolved_dag(resolve_prec_refs(this->dag, job_index))
+		, abort_job_positions(resolve_abort_refs<Time>(this->aborts, this->jobs, job_index))
 		{
 			assert(num_processors > 0);
-			validate_prec_refs<Time>(dag, jobs);
-			validate_abort_refs<Time>(aborts, jobs);
 		}
 
 		// Convenience constructor: no DAG, no abort actions
 		Scheduling_problem(Workload jobs,
 		                   unsigned int num_processors = 1)
-		: jobs(jobs)
-		, num_processors(num_processors)
+		: Scheduling_problem(std::move(jobs), Precedence_constraints(),
+		                     Abort_actions(), num_processors)
 		{
-			assert(num_processors > 0);
 		}
 	};
 
+	// How the global analysis finds the states that it can merge
+	enum class Merge_strategy {
+		// look up each new state in a hash table of its depth
+		hashing,
+		// create all states of a depth first, then sort them by key
+		// and merge them in one pass over the sorted sequence
+		sorting
+	};
+
 	// Common options to pass to the analysis engines
 	struct Analysis_options {
 		// After how many seconds of CPU time should we give up?
@@ -86,12 +107,50 @@ namespace NP {
 		// of the main workload index be?
 		std::size_t num_buckets;
 
+		// Global analysis only: how to find states to merge (irrelevant
+		// if be_naive is set).
+		Merge_strategy merge_strategy;
+
+		// Global analysis only: should states be merged based on their
+		// 128-bit fingerprints alone, without comparing their sets of
+		// scheduled jobs? Treating the fingerprints of the jobs as
+		// random, the probability that any two of n states of the same
+		// depth with different jobs share a fingerprint is below
+		// n^2 / 2^129 (e.g., below 10^-20 for a billion states), in which
+		// case the analysis could become unsound.
+		bool trust_fingerprints;
+
+		// Global analysis only: how many states of the next depth may be
+		// held in memory before they are spilled to disk? Zero means
+		// unlimited (i.e., never spill).
+		std::size_t frontier_budget;
+
+		// Where to put spilled states (by default, the system's
+		// temporary directory).
+		std::string spill_directory;
+
+		// If set, the analysis saves its progress to this file at the
+		// start of a depth whenever at least checkpoint_interval seconds
+		// (of wall-clock time) have passed since the last checkpoint
+		// (see checkpoint.hpp).
+		std::string checkpoint_file;
+		double checkpoint_interval;
+
+		// Should the analysis continue from checkpoint_file (if it
+		// exists) instead of starting from scratch?
+		bool resume;
+
 		Analysis_options()
 		: timeout(0)
 		, max_depth(0)
 		, early_exit(true)
 		, num_buckets(1000)
 		, be_naive(false)
+		, merge_strategy(Merge_strategy::hashing)
+		, trust_fingerprints(false)
+		, frontier_budget(0)
+		, checkpoint_interval(600)
+		, resume(false)
 		{
 		}
 	};
@@ -0,0 +1,55 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+namespace NP {
+
+	// Sorts items stably by a 64-bit key, one byte at a time starting
+	// with the least significant one. The counts of all bytes are taken
+	// in a single pass, and bytes in which all keys agree are skipped,
+	// so keys that differ only in a few bytes cost only a few passes.
+	// Short sequences are simply handed to std::stable_sort.
+	template<class T, class Key>
+	void radix_sort(std::vector<T>& items, Key key)
+	{
+		const std::size_t n = items.size();
+
+		if (n < 256) {
+			std::stable_sort(items.begin(), items.end(),
+			                 [&key] (const T& a, const T& b) {
+				return key(a) < key(b);
+			});
+			return;
+		}
+
+		std::vector<std::size_t> counts(8 * 256, 0);
+		for (const T& x : items) {
+			std::uint64_t k = key(x);
+			for (unsigned int b = 0; b < 8; b++)
+				counts[b * 256 + ((k >> (8 * b)) & 0xff)]++;
+		}
+
+		std::vector<T> buffer(n);
+		for (unsigned int b = 0; b < 8; b++) {
+			std::size_t* offset = &counts[b * 256];
+			// all keys share this byte
+			if (offset[(std::uint64_t(key(items[0])) >> (8 * b)) & 0xff] == n)
+				continue;
+			std::size_t sum = 0;
+			for (unsigned int d = 0; d < 256; d++) {
+				std::size_t c = offset[d];
+				offset[d] = sum;
+				sum += c;
+			}
+			for (const T& x : items)
+				buffer[offset[(std::uint64_t(key(x)) >> (8 * b)) & 0xff]++] = x;
+			items.swap(buffer);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef TIME_INDEX_HPP
+#define TIME_INDEX_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+#include "jobs.hpp"
+
+namespace NP {
+
+	// The jobs of a workload sorted by a time key (e.g., their latest
+	// arrival time), with ties in workload order. The index is built once
+	// and then only searched and scanned, so it is kept as a flat array
+	// that stores each key next to the position of its job.
+	template<class Time> class Time_index
+	{
+		public:
+
+		struct Entry {
+			Time key;
+			std::size_t job;
+		};
+
+		typedef typename std::vector<Entry>::const_iterator const_iterator;
+
+		Time_index()
+		{
+		}
+
+		Time_index(const std::vector<Job<Time>>& jobs,
+		           Time (Job<Time>::*key)() const)
+		{
+			entries.reserve(jobs.size());
+			for (std::size_t i = 0; i < jobs.size(); i++)
+				entries.push_back(Entry{(jobs[i].*key)(), i});
+			std::stable_sort(entries.begin(), entries.end(),
+			                 [] (const Entry& a, const Entry& b) {
+				return a.key < b.key;
+			});
+		}
+
+		std::size_t size() const
+		{
+			return entries.size();
+		}
+
+		const Entry& operator[](std::size_t pos) const
+		{
+			return entries[pos];
+		}
+
+		const_iterator begin() const
+		{
+			return entries.begin();
+		}
+
+		const_iterator end() const
+		{
+			return entries.end();
+		}
+
+		// first entry at or after position from with a key of at least t
+		const_iterator lower_bound(Time t, std::size_t from = 0) const
+		{
+			return search(from, [t] (const Entry& e) { return e.key < t; });
+		}
+
+		// first entry at or after position from with a key greater than t
+		const_iterator upper_bound(Time t, std::size_t from = 0) const
+		{
+			return search(from, [t] (const Entry& e) { return !(t < e.key); });
+		}
+
+		private:
+
+		std::vector<Entry> entries;
+
+		// Branchless binary search for the first entry (at or after from)
+		// that is not before the sought position: the loop always runs
+		// log(n) times and compiles to conditional moves, which avoids
+		// mispredicted branches in the hot loops of the exploration.
+		template<class Before>
+		const_iterator search(std::size_t from, Before before) const
+		{
+			std::size_t n = entries.size() - std::min(from, entries.size());
+			if (!n)
+				return end();
+			const Entry* base = entries.data() + from;
+			while (n > 1) {
+				std::size_t half = n / 2;
+				base = before(base[half]) ? base + half : base;
+				n -= half;
+			}
+			return begin() + ((base - entries.data()) + before(*base));
+		}
+	};
+}
+
+#endif
@@ -17,6 +17,9 @@ namespace NP {
 
 			static const bool can_block = false;
 
+			// identifies the policy in checkpoints
+			static const unsigned int id = 0;
+
 			Null_IIP(const Space &space, const Jobs &jobs) {}
 
 			Time latest_start(const Job<Time>& j, Time t, const State& s)
@@ -37,6 +40,9 @@ namespace NP {
 
 			static const bool can_block = true;
 
+			// identifies the policy in checkpoints
+			static const unsigned int id = 1;
+
 			Precatious_RM_IIP(const Space &space, const Jobs &jobs)
 			: space(space), max_priority(highest_prio(jobs))
 			{
@@ -103,6 +109,9 @@ namespace NP {
 
 			static const bool can_block = true;
 
+			// identifies the policy in checkpoints
+			static const unsigned int id = 2;
+
 			Critical_window_IIP(const Space &space, const Jobs &jobs)
 			: space(space)
 			, max_cost(maximal_cost(jobs))
@@ -155,12 +164,12 @@ namespace NP {
 
 				// first, check everything that's already pending at time t
 				// is accounted for
-				for (auto it = space.jobs_by_earliest_arrival
-				                    .lower_bound(s.earliest_job_release());
+				for (auto it = space.jobs_by_earliest_arrival.begin()
+				               + s.job_cursors().by_earliest_arrival;
 				     it != space.jobs_by_earliest_arrival.end()
-				     && it->second->earliest_arrival() <= at;
+				     && it->key <= at;
 				     it++) {
-					const Job<Time>& j = *(it->second);
+					const Job<Time>& j = space.jobs[it->job];
 					auto tid = j.get_task_id();
 					if (j_i.get_task_id() != tid
 					    && space.incomplete(s, j)
@@ -184,7 +193,7 @@ namespace NP {
 				     ijs.size() < n_tasks - 1
 					   && it != space.jobs_by_earliest_arrival.end();
 					 it++) {
-					const Job<Time>& j = *it->second;
+					const Job<Time>& j = space.jobs[it->job];
 					auto tid = j.get_task_id();
 
 					// future jobs should still be pending...
@@ -197,7 +206,7 @@ namespace NP {
 					}
 
 					// can we stop searching already?
-					if (latest_deadline + max_cost < it->first) {
+					if (latest_deadline + max_cost < it->key) {
 						// we have reached the horizon --- whatever comes now
 						// cannot influence the latest start time anymore
 					 	break;
@@ -8,6 +8,8 @@
 #include <deque>
 #include <list>
 #include <algorithm>
+#include <chrono>
+#include <stdexcept>
 
 #include <iostream>
 #include <ostream>
@@ -18,6 +20,9 @@
 #include "jobs.hpp"
 #include "precedence.hpp"
 #include "clock.hpp"
+#include "frontier.hpp"
+#include "time_index.hpp"
+#include "checkpoint.hpp"
 
 #include "uni/state.hpp"
 
@@ -43,9 +48,24 @@ namespace NP {
 				// this is a uniprocessor analysis
 				assert(prob.num_processors == 1);
 
-				auto s = State_space(prob.jobs, prob.dag, prob.aborts,
+#ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
+				if (!opts.checkpoint_file.empty())
+					throw std::invalid_argument(
+						"checkpoints are not supported when collecting "
+						"the schedule graph");
+#endif
+
+				auto s = State_space(prob.jobs, prob.resolved_dag,
+				                     prob.aborts, prob.abort_job_positions,
 				                     opts.timeout, opts.max_depth,
 				                     opts.num_buckets, opts.early_exit);
+				s.checkpoint_file = opts.checkpoint_file;
+				s.checkpoint_interval = opts.checkpoint_interval;
+				s.checkpoint_header = Checkpoint::make_header(prob, opts,
+					checkpoint_engine_id);
+				s.resuming = opts.resume && !opts.checkpoint_file.empty()
+				             && Checkpoint::exists(opts.checkpoint_file);
+				s.last_checkpoint = std::chrono::steady_clock::now();
 				s.cpu_time.start();
 				if (opts.be_naive)
 					s.explore_naively();
@@ -72,14 +92,20 @@ namespace NP {
 				return explore(p, o);
 			}
 
+			// finish times of the job at the given position in the workload;
+			// jobs that were never scheduled yield [0, infinity]
+			Interval<Time> get_finish_times(std::size_t index) const
+			{
+				return Interval<Time>{rta[index]};
+			}
+
+			// The job is identified by its ID, so it need not be part of
+			// the analyzed copy of the workload.
 			Interval<Time> get_finish_times(const Job<Time>& j) const
 			{
-				auto rbounds = rta.find(j.get_id());
-				if (rbounds == rta.end()) {
+				if (!job_index.contains(j.get_id()))
 					return Interval<Time>{0, Time_model::constants<Time>::infinity()};
-				} else {
-					return rbounds->second;
-				}
+				return get_finish_times(job_index.position_of(j.get_id()));
 			}
 
 			bool is_schedulable() const
@@ -112,6 +138,16 @@ namespace NP {
 				return cpu_time;
 			}
 
+			// per-worker load statistics (empty in sequential builds)
+			Workers_stats get_worker_stats() const
+			{
+#ifdef CONFIG_PARALLEL
+				return frontier.get_stats();
+#else
+				return Workers_stats();
+#endif
+			}
+
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
 
 			struct Edge {
@@ -176,14 +212,23 @@ namespace NP {
 			typedef std::unordered_multimap<hash_value_t, State_ref> States_map;
 
 			typedef const Job<Time>* Job_ref;
-			typedef std::multimap<Time, Job_ref> By_time_map;
+			typedef Time_index<Time> By_time_index;
 
 			typedef std::deque<State_ref> Todo_queue;
 
-			typedef std::unordered_map<JobID, Interval<Time> > Response_times;
+			// finish-time bounds, indexed like the jobs
+			typedef std::vector<std::pair<Time, Time>> Response_times;
 
 			typedef std::vector<std::size_t> Job_precedence_set;
 
+			// a job that can be scheduled next in some state
+			struct Successor {
+				const Job<Time>* job;
+				Interval<Time> finish_range;
+			};
+
+			typedef std::vector<Successor> Successors;
+
 
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
 			std::deque<Edge> edges;
@@ -193,6 +238,7 @@ namespace NP {
 			friend IIP;
 
 			Response_times rta;
+			Job_id_index job_index;
 			bool aborted;
 			bool timed_out;
 
@@ -200,9 +246,8 @@ namespace NP {
 
 			std::vector<Job_precedence_set> job_precedence_sets;
 
-			By_time_map jobs_by_latest_arrival;
-			By_time_map jobs_by_earliest_arrival;
-			By_time_map jobs_by_deadline;
+			By_time_index jobs_by_latest_arrival;
+			By_time_index jobs_by_earliest_arrival;
 
 			std::vector<const Abort_action<Time>*> abort_actions;
 
@@ -224,43 +269,56 @@ namespace NP {
 			bool early_exit;
 			bool observed_deadline_miss;
 
+#ifdef CONFIG_PARALLEL
+			Frontier_scheduler frontier;
+#endif
+
+			// identifies this analysis (and its IIP) in checkpoints
+			static const std::uint32_t checkpoint_engine_id = 0x100 | IIP::id;
+
+			std::string checkpoint_file;
+			double checkpoint_interval;
+			Checkpoint::Header checkpoint_header;
+			std::chrono::steady_clock::time_point last_checkpoint;
+			bool resuming;
+
 			State_space(const Workload& jobs,
-			            const Precedence_constraints &dag_edges,
+			            const Resolved_precedence_constraints &dag_edges,
 			            const Abort_actions& aborts,
+			            const std::vector<std::size_t>& abort_job_positions,
 			            double max_cpu_time = 0,
 			            unsigned int max_depth = 0,
 			            std::size_t num_buckets = 1000,
 			            bool early_exit = true)
-			: jobs(jobs)
+			: iip(*this, jobs)
+			, rta(Response_times(jobs.size(), {Time_model::constants<Time>::infinity(), 0}))
+			, job_index(jobs)
 			, aborted(false)
 			, timed_out(false)
-			, timeout(max_cpu_time)
-			, max_depth(max_depth)
-			, iip(*this, jobs)
+			, jobs(jobs)
+			, job_precedence_sets(jobs.size())
+			, jobs_by_latest_arrival(jobs, &Job<Time>::latest_arrival)
+			, jobs_by_earliest_arrival(jobs, &Job<Time>::earliest_arrival)
+			, abort_actions(jobs.size(), NULL)
 			, num_states(0)
 			, num_edges(0)
 			, width(0)
 			, todo_idx(0)
 			, current_job_count(0)
-			, job_precedence_sets(jobs.size())
+			, timeout(max_cpu_time)
+			, max_depth(max_depth)
 			, early_exit(early_exit)
 			, observed_deadline_miss(false)
-			, abort_actions(jobs.size(), NULL)
+#ifdef CONFIG_PARALLEL
+			, frontier(8)
+#endif
+			, checkpoint_interval(0)
+			, resuming(false)
 			{
-				for (const Job<Time>& j : jobs) {
-					jobs_by_latest_arrival.insert({j.latest_arrival(), &j});
-					jobs_by_earliest_arrival.insert({j.earliest_arrival(), &j});
-					jobs_by_deadline.insert({j.get_deadline(), &j});
-				}
-				for (auto e : dag_edges) {
-					const Job<Time>& from = lookup<Time>(jobs, e.first);
-					const Job<Time>& to   = lookup<Time>(jobs, e.second);
-					job_precedence_sets[index_of(to)].push_back(index_of(from));
-				}
-				for (const Abort_action<Time>& a : aborts) {
-					const Job<Time>& j = lookup<Time>(jobs, a.get_id());
-					abort_actions[index_of(j)] = &a;
-				}
+				for (auto e : dag_edges)
+					job_precedence_sets[e.second].push_back(e.first);
+				for (std::size_t i = 0; i < aborts.size(); i++)
+					abort_actions[abort_job_positions[i]] = &aborts[i];
 			}
 
 			private:
@@ -275,18 +333,13 @@ namespace NP {
 
 			void update_finish_times(const Job<Time>& j, Interval<Time> range)
 			{
-				auto rbounds = rta.find(j.get_id());
-				if (rbounds == rta.end()) {
-					rta.emplace(j.get_id(), range);
-					if (j.exceeds_deadline(range.upto()))
-						observed_deadline_miss = true;
-				} else {
-					rbounds->second.widen(range);
-					if (j.exceeds_deadline(rbounds->second.upto()))
-						observed_deadline_miss = true;
-				}
+				auto& r = rta[index_of(j)];
+				r.first = std::min(r.first, range.from());
+				r.second = std::max(r.second, range.upto());
+				if (j.exceeds_deadline(r.second))
+					observed_deadline_miss = true;
 				DM("      New finish time range for " << j
-				   << ": " << rta.find(j.get_id())->second << std::endl);
+				   << ": " << Interval<Time>{r} << std::endl);
 
 				if (early_exit && observed_deadline_miss)
 					aborted = true;
@@ -307,22 +360,59 @@ namespace NP {
 				return incomplete(s.get_scheduled_jobs(), j);
 			}
 
+			// Where to start looking for incomplete jobs (in order of latest
+			// arrival) that are certainly released no earlier than t: the
+			// jobs before the state's cursor are complete anyway.
+			typename By_time_index::const_iterator
+			first_candidate_by_latest_arrival(const State& s, Time t) const
+			{
+				return jobs_by_latest_arrival.lower_bound(
+					t, s.job_cursors().by_latest_arrival);
+			}
+
+			// Advance the cursors of s past the jobs that are complete once
+			// j has been scheduled in s.
+			Job_cursors successor_cursors(const State& s, const Job<Time>& j) const
+			{
+				const Scheduled& scheduled = s.get_scheduled_jobs();
+				auto idx = index_of(j);
+				auto skip_complete = [&] (const By_time_index& order, std::size_t pos) {
+					while (pos < order.size()
+					       && (order[pos].job == idx
+					           || scheduled.contains(order[pos].job)))
+						pos++;
+					return pos;
+				};
+				const Job_cursors& c = s.job_cursors();
+				return Job_cursors{
+					skip_complete(jobs_by_earliest_arrival, c.by_earliest_arrival),
+					skip_complete(jobs_by_latest_arrival, c.by_latest_arrival)
+				};
+			}
+
+			// earliest release of any incomplete job, given the cursors
+			Time earliest_pending_release(const Job_cursors& c) const
+			{
+				if (c.by_earliest_arrival == jobs_by_earliest_arrival.size())
+					return Time_model::constants<Time>::infinity();
+				return jobs_by_earliest_arrival[c.by_earliest_arrival].key;
+			}
+
 			// find next time by which a job is certainly released
 			Time next_certain_job_release(const State& s)
 			{
 				const Scheduled &already_scheduled = s.get_scheduled_jobs();
 
-				for (auto it = jobs_by_latest_arrival
-				               .lower_bound(s.earliest_finish_time());
+				for (auto it = first_candidate_by_latest_arrival(s, s.earliest_finish_time());
 				     it != jobs_by_latest_arrival.end(); it++) {
-					const Job<Time>& j = *(it->second);
-
-					DM(__FUNCTION__ << " considering:: "  << j << std::endl);
-
 					// not relevant if already scheduled
-					if (!incomplete(already_scheduled, j))
+					if (already_scheduled.contains(it->job))
 						continue;
 
+					const Job<Time>& j = jobs[it->job];
+
+					DM(__FUNCTION__ << " considering:: "  << j << std::endl);
+
 					// If the job is not IIP-eligible when it is certainly
 					// released, then there exists a schedule where it doesn't
 					// count, so skip it.
@@ -350,15 +440,16 @@ namespace NP {
 				const Job<Time>& reference_job)
 			{
 
-				for (auto it = jobs_by_latest_arrival
-				               .lower_bound(s.earliest_finish_time());
-				     it != jobs_by_latest_arrival.end(); it++) {
-					const Job<Time>& j = *(it->second);
+				const Scheduled &already_scheduled = s.get_scheduled_jobs();
 
+				for (auto it = first_candidate_by_latest_arrival(s, s.earliest_finish_time());
+				     it != jobs_by_latest_arrival.end(); it++) {
 					// not relevant if already scheduled
-					if (!incomplete(s, j))
+					if (already_scheduled.contains(it->job))
 						continue;
 
+					const Job<Time>& j = jobs[it->job];
+
 					// irrelevant if not of sufficient priority
 					if (!j.higher_priority_than(reference_job))
 						continue;
@@ -372,24 +463,16 @@ namespace NP {
 
 // define a couple of iteration helpers
 
-// Iterate over all incomplete jobs in state ppj_macro_local_s.
-// ppj_macro_local_j is of type const Job<Time>*
-#define foreach_possibly_pending_job(ppj_macro_local_s, ppj_macro_local_j) 	\
-	for (auto ppj_macro_local_it = jobs_by_earliest_arrival			\
-                     .lower_bound((ppj_macro_local_s).earliest_job_release()); \
-	     ppj_macro_local_it != jobs_by_earliest_arrival.end() 				\
-	        && (ppj_macro_local_j = ppj_macro_local_it->second); 	\
-	     ppj_macro_local_it++) \
-		if (incomplete(ppj_macro_local_s, *ppj_macro_local_j))
-
 // Iterate over all incomplete jobs that are released no later than ppju_macro_local_until
+// ppju_macro_local_j is of type const Job<Time>*
 #define foreach_possbly_pending_job_until(ppju_macro_local_s, ppju_macro_local_j, ppju_macro_local_until) 	\
-	for (auto ppju_macro_local_it = jobs_by_earliest_arrival			\
-                     .lower_bound((ppju_macro_local_s).earliest_job_release()); \
+	for (auto ppju_macro_local_it = jobs_by_earliest_arrival.begin()			\
+                     + (ppju_macro_local_s).job_cursors().by_earliest_arrival; \
 	     ppju_macro_local_it != jobs_by_earliest_arrival.end() 				\
-	        && (ppju_macro_local_j = ppju_macro_local_it->second, ppju_macro_local_j->earliest_arrival() <= (ppju_macro_local_until)); 	\
+	        && ppju_macro_local_it->key <= (ppju_macro_local_until); 	\
 	     ppju_macro_local_it++) \
-		if (incomplete(ppju_macro_local_s, *ppju_macro_local_j))
+		if (!(ppju_macro_local_s).get_scheduled_jobs().contains(ppju_macro_local_it->job) \
+		    && (ppju_macro_local_j = &jobs[ppju_macro_local_it->job]))
 
 // Iterare over all incomplete jobs that are certainly released no later than
 // cpju_macro_local_until
@@ -433,33 +516,6 @@ namespace NP {
 				return false;
 			}
 
-			Time earliest_possible_job_release(
-				const State& s,
-				const Job<Time>& ignored_job)
-			{
-				DM("      - looking for earliest possible job release starting from: "
-				   << s.earliest_job_release() << std::endl);
-				const Job<Time>* jp;
-				foreach_possibly_pending_job(s, jp) {
-					const Job<Time>& j = *jp;
-
-					DM("         * looking at " << j << std::endl);
-
-					// skip if it is the one we're ignoring
-					if (&j == &ignored_job)
-						continue;
-
-					DM("         * found it: " << j.earliest_arrival() << std::endl);
-
-					// it's incomplete and not ignored => found the earliest
-					return j.earliest_arrival();
-				}
-
-				DM("         * No more future releases" << std::endl);
-
-				return Time_model::constants<Time>::infinity();
-			}
-
 			bool iip_eligible(const State &s, const Job<Time> &j, Time t)
 			{
 				return !iip.can_block || t <= iip.latest_start(j, t, s);
@@ -543,8 +599,78 @@ namespace NP {
 
 			void make_initial_state()
 			{
-				// construct initial state
-				new_state();
+				if (resuming)
+					resume_from_checkpoint();
+				else
+					// construct initial state
+					new_state(jobs.size());
+			}
+
+			// Save the front of the depth that is about to be explored,
+			// unless the analysis has already failed. (Stopping at the
+			// depth limit is fine: a later analysis may go deeper.)
+			void checkpoint_if_due()
+			{
+				if (checkpoint_file.empty() || timed_out
+				    || (early_exit && observed_deadline_miss))
+					return;
+				auto now = std::chrono::steady_clock::now();
+				if (now - last_checkpoint
+				    < std::chrono::duration<double>(checkpoint_interval))
+					return;
+				write_checkpoint();
+				last_checkpoint = std::chrono::steady_clock::now();
+			}
+
+			void write_checkpoint()
+			{
+				Checkpoint::Header h = checkpoint_header;
+				if (observed_deadline_miss)
+					h.flags |= Checkpoint::deadline_miss;
+				h.depth = current_job_count;
+				h.num_states = num_states;
+				h.num_edges = num_edges;
+				h.width = width;
+				h.cpu_time = cpu_time;
+
+				Checkpoint::Writer out(checkpoint_file);
+				out.write_value(h);
+				out.write_finish_times(rta);
+
+				const Todo_queue& front = todo[todo_idx];
+				out.write_value(std::uint64_t(front.size()));
+				std::vector<std::uint64_t> flat(State::flat_size(jobs.size()));
+				for (State_ref s : front) {
+					s->flatten(flat.data(), jobs.size());
+					out.write(flat.data(), flat.size() * sizeof(std::uint64_t));
+				}
+				out.commit();
+			}
+
+			void resume_from_checkpoint()
+			{
+				Checkpoint::Reader in(checkpoint_file);
+				auto h = in.read_header(checkpoint_header);
+				in.read_finish_times(rta);
+
+				observed_deadline_miss = h.flags & Checkpoint::deadline_miss;
+				current_job_count = h.depth;
+				todo_idx = current_job_count % num_todo_queues;
+				num_states = h.num_states;
+				num_edges = h.num_edges;
+				width = h.width;
+				cpu_time.add(h.cpu_time);
+
+				// the front, in the order in which it was created
+				auto n = in.read_value<std::uint64_t>();
+				std::vector<std::uint64_t> flat(State::flat_size(jobs.size()));
+				for (std::uint64_t i = 0; i < n; i++) {
+					in.read(flat.data(), flat.size() * sizeof(std::uint64_t));
+					states.emplace_back(flat.data(), jobs.size());
+					State_ref s = &states.back();
+					todo[todo_idx].push_back(s);
+					states_by_key.insert(std::make_pair(s->get_key(), s));
+				}
 			}
 
 			template <typename... Args>
@@ -573,7 +699,10 @@ namespace NP {
 				if (todo[todo_idx].empty()) {
 					current_job_count++;
 					todo_idx = current_job_count % num_todo_queues;
-					return !todo[todo_idx].empty();
+					if (todo[todo_idx].empty())
+						return false;
+					checkpoint_if_due();
+					return true;
 				} else
 					return true;
 			}
@@ -657,13 +786,15 @@ namespace NP {
 			Time next_eligible_job_ready(const State& s) {
 			    const Scheduled& already_scheduled = s.get_scheduled_jobs();
 
-			    for (auto it = jobs_by_latest_arrival.begin(); it != jobs_by_latest_arrival.end(); it++) {
-			        const Job<Time>& j = *(it->second);
-
+			    // all jobs before the cursor are complete
+			    for (auto it = jobs_by_latest_arrival.begin() + s.job_cursors().by_latest_arrival;
+			         it != jobs_by_latest_arrival.end(); it++) {
 			        // not relevant if already scheduled
-			        if (!incomplete(already_scheduled, j))
+			        if (already_scheduled.contains(it->job))
 			            continue;
 
+			        const Job<Time>& j = jobs[it->job];
+
 			        auto t = std::max(j.latest_arrival(), s.latest_finish_time());
 
 			        if (priority_eligible(s, j, t) && iip_eligible(s, j, t))
@@ -764,13 +895,19 @@ namespace NP {
 #endif
 			}
 
+			// creates the state that results from scheduling j in s
+			const State& new_successor(const State& s, const Job<Time>& j,
+			                           const Interval<Time>& finish_range)
+			{
+				auto cursors = successor_cursors(s, j);
+				return new_state(s, index_of(j), finish_range,
+				                 earliest_pending_release(cursors), cursors);
+			}
+
 			// naive: no state merging
 			void schedule_job(const State &s, const Job<Time> &j)
 			{
-				const State& next =
-					new_state(s, j, index_of(j),
-					          next_finish_times(s, j),
-					          earliest_possible_job_release(s, j));
+				const State& next = new_successor(s, j, next_finish_times(s, j));
 				DM("      -----> S" << (states.end() - states.begin())
 				   << std::endl);
 				process_new_edge(s, next, j, next.finish_range());
@@ -836,11 +973,10 @@ namespace NP {
 			}
 
 
-			void schedule(const State &s, const Job<Time> &j)
+			void schedule(const State &s, const Job<Time> &j,
+			              const Interval<Time>& finish_range)
 			{
-				Interval<Time> finish_range = next_finish_times(s, j);
-
-				auto k = s.next_key(j);
+				auto k = s.next_key(index_of(j));
 
 				auto r = states_by_key.equal_range(k);
 
@@ -868,76 +1004,120 @@ namespace NP {
 
 				// If we reach here, we didn't find a match and need to create
 				// a new state.
-				const State& next =
-					new_state(s, j, index_of(j),
-					          finish_range,
-					          earliest_possible_job_release(s, j));
+				const State& next = new_successor(s, j, finish_range);
 				DM("      -----> S" << (states.end() - states.begin())
 				   << std::endl);
 				process_new_edge(s, next, j, finish_range);
 			}
 
-			void explore()
+			// Finds all jobs that can be scheduled next in state s. This
+			// does not modify the state space, so it can be called for
+			// several states concurrently.
+			void find_successors(const State& s, Successors& next)
 			{
-				make_initial_state();
+				DM("\n==================================================="
+				   << std::endl);
+				DM("Looking at: " << s << std::endl);
 
-				while (not_done() && !aborted) {
-					const State& s = next_state();
+				// Identify relevant interval for next job
+				// relevant job buckets
+				auto ts_min = s.earliest_finish_time();
+				auto rel_min = s.earliest_job_release();
+				auto t_l = std::max(next_eligible_job_ready(s), s.latest_finish_time());
 
-					DM("\n==================================================="
-					   << std::endl);
-					DM("Looking at: S"
-					   << (todo[todo_idx].front() - states.begin() + 1)
-					   << " " << s << std::endl);
+				Interval<Time> next_range{std::min(ts_min, rel_min), t_l};
 
-					// Identify relevant interval for next job
-					// relevant job buckets
-					auto ts_min = s.earliest_finish_time();
-					auto rel_min = s.earliest_job_release();
-					auto t_l = std::max(next_eligible_job_ready(s), s.latest_finish_time());
+				DM("ts_min = " << ts_min << std::endl <<
+				   "rel_min = " << rel_min << std::endl <<
+				   "latest_finish = " << s.latest_finish_time() << std::endl);
+				DM("=> next range = " << next_range << std::endl);
 
-					Interval<Time> next_range{std::min(ts_min, rel_min), t_l};
+				DM("\n---\nChecking for pending and later-released jobs:"
+				   << std::endl);
+				const Job<Time>* jp;
+				foreach_possbly_pending_job_until(s, jp, next_range.upto()) {
+					const Job<Time>& j = *jp;
+					DM("+ " << j << std::endl);
+					// if it can be scheduled next...
+					if (is_eligible_successor(s, j)) {
+						DM("  --> can be next "  << std::endl);
+						next.push_back(Successor{&j, next_finish_times(s, j)});
+					}
+				}
 
-					DM("ts_min = " << ts_min << std::endl <<
-					   "rel_min = " << rel_min << std::endl <<
-					   "latest_finish = " << s.latest_finish_time() << std::endl);
-					DM("=> next range = " << next_range << std::endl);
+				DM("---\nDone iterating over all jobs." << std::endl);
+			}
 
-					bool found_at_least_one = false;
+			// Creates (or merges) the successors of the current state and
+			// moves on to the next state.
+			void process_successors(const State& s, const Successors& next)
+			{
+				for (const Successor& x : next)
+					schedule(s, *x.job, x.finish_range);
+
+				// check for a dead end
+				if (next.empty() &&
+				    s.get_scheduled_jobs().size() != jobs.size()) {
+					// out of options and we didn't schedule all jobs
+					observed_deadline_miss = true;
+					if (early_exit)
+						aborted = true;
+					DM(":: Didn't find any possible successors." << std::endl);
+				}
 
-					DM("\n---\nChecking for pending and later-released jobs:"
-					   << std::endl);
-					const Job<Time>* jp;
-					foreach_possbly_pending_job_until(s, jp, next_range.upto()) {
-						const Job<Time>& j = *jp;
-						DM("+ " << j << std::endl);
-						// if it can be scheduled next...
-						if (is_eligible_successor(s, j)) {
-							DM("  --> can be next "  << std::endl);
-							// create the relevant state and continue
-							schedule(s, j);
-							found_at_least_one = true;
-						}
-					}
+				done_with_current_state();
+				check_cpu_timeout();
+				check_depth_abort();
+			}
 
-					DM("---\nDone iterating over all jobs." << std::endl);
+#ifdef CONFIG_PARALLEL
 
-					// check for a dead end
-					if (!found_at_least_one &&
-					    s.get_scheduled_jobs().size() != jobs.size()) {
-						// out of options and we didn't schedule all jobs
-						observed_deadline_miss = true;
-						if (early_exit)
-							aborted = true;
-						DM(":: Didn't find any possible successors." << std::endl);
+			// Level-synchronous exploration: the successors of all states
+			// of the current depth are searched for in parallel, and then
+			// created or merged one state at a time, in the same order as
+			// in the sequential exploration. The results are thus identical.
+			void explore()
+			{
+				make_initial_state();
+
+				std::vector<State_ref> front;
+				std::vector<Successors> next;
+
+				while (not_done() && !aborted) {
+					const Todo_queue& current = todo[todo_idx];
+					front.assign(current.begin(), current.end());
+					next.resize(front.size());
+
+					frontier.run_range(front.size(), [&] (std::size_t i) {
+						next[i].clear();
+						find_successors(*front[i], next[i]);
+					});
+
+					for (std::size_t i = 0; i < front.size() && !aborted; i++) {
+						assert(&next_state() == front[i]);
+						process_successors(*front[i], next[i]);
 					}
+				}
+			}
 
-					done_with_current_state();
-					check_cpu_timeout();
-					check_depth_abort();
+#else
+
+			void explore()
+			{
+				make_initial_state();
+
+				Successors next;
+
+				while (not_done() && !aborted) {
+					const State& s = next_state();
+					next.clear();
+					find_successors(s, next);
+					process_successors(s, next);
 				}
 			}
 
+#endif
+
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
 			friend std::ostream& operator<< (std::ostream& out,
 			                                 const State_space<Time, IIP>& space)
@@ -2,6 +2,8 @@
 #include <ostream>
 #include <cassert>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 
 #include <set>
 
@@ -15,7 +17,16 @@ namespace NP {
 
 	namespace Uniproc {
 
-		typedef Index_set Job_set;
+		typedef Scheduled_set<> Job_set;
+
+		// Positions of the first incomplete job in the workload sorted by
+		// earliest and by latest arrival time, respectively. Jobs are only
+		// ever added to the set of scheduled jobs, so the successors of a
+		// state resume the scans of these orders where the state left off.
+		struct Job_cursors {
+			std::size_t by_earliest_arrival;
+			std::size_t by_latest_arrival;
+		};
 
 		template<class Time> class Schedule_state
 		{
@@ -26,10 +37,20 @@ namespace NP {
 
 			Job_set scheduled_jobs;
 			hash_value_t lookup_key;
+			Job_cursors cursors;
 
 			// no accidental copies
 			Schedule_state(const Schedule_state& origin)  = delete;
 
+			static Time time_at(const std::uint64_t* w)
+			{
+				static_assert(sizeof(Time) == sizeof(std::uint64_t),
+				              "checkpoints store 64-bit time values");
+				Time t;
+				std::memcpy(&t, w, sizeof(Time));
+				return t;
+			}
+
 			public:
 
 			// initial state
@@ -37,23 +58,63 @@ namespace NP {
 			: finish_time{0, 0}
 			, lookup_key{0}
 			, earliest_pending_release{0}
+			, cursors{0, 0}
+			{
+			}
+
+			// initial state, with the job set sized for the whole workload
+			explicit Schedule_state(std::size_t num_jobs)
+			: finish_time{0, 0}
+			, scheduled_jobs{num_jobs}
+			, lookup_key{0}
+			, earliest_pending_release{0}
+			, cursors{0, 0}
 			{
 			}
 
 			// transition: new state by scheduling a job in an existing state
 			Schedule_state(
 				const Schedule_state& from,
-				const Job<Time>& j,
 				std::size_t idx,
 				Interval<Time> ftimes,
-				const Time next_earliest_release)
+				const Time next_earliest_release,
+				const Job_cursors& next_cursors)
 			: finish_time{ftimes}
 			, scheduled_jobs{from.scheduled_jobs, idx}
-			, lookup_key{from.next_key(j)}
+			, lookup_key{from.next_key(idx)}
 			, earliest_pending_release{next_earliest_release}
+			, cursors{next_cursors}
 			{
 			}
 
+			// Flat representation for checkpoints: the finish times, the
+			// earliest pending release, the key, the cursors, and the set
+			// of scheduled jobs, as 64-bit words.
+			static std::size_t flat_size(std::size_t num_jobs)
+			{
+				return 6 + Job_set::words_needed(num_jobs);
+			}
+
+			explicit Schedule_state(const std::uint64_t* flat, std::size_t num_jobs)
+			: finish_time{time_at(flat), time_at(flat + 1)}
+			, earliest_pending_release{time_at(flat + 2)}
+			, scheduled_jobs{num_jobs, flat + 6}
+			, lookup_key{flat[3]}
+			, cursors{flat[4], flat[5]}
+			{
+			}
+
+			void flatten(std::uint64_t* flat, std::size_t num_jobs) const
+			{
+				Time times[3] = {finish_time.from(), finish_time.until(),
+				                 earliest_pending_release};
+				std::memcpy(flat, times, sizeof(times));
+				flat[3] = lookup_key;
+				flat[4] = cursors.by_earliest_arrival;
+				flat[5] = cursors.by_latest_arrival;
+				scheduled_jobs.copy_words(flat + 6, Job_set::words_needed(num_jobs));
+			}
+
 			Time earliest_finish_time() const
 			{
 				return finish_time.from();
@@ -69,6 +130,11 @@ namespace NP {
 				return earliest_pending_release;
 			}
 
+			const Job_cursors& job_cursors() const
+			{
+				return cursors;
+			}
+
 			const Interval<Time>& finish_range() const
 			{
 				return finish_time;
@@ -96,9 +162,10 @@ namespace NP {
 					   scheduled_jobs == other.scheduled_jobs;
 			}
 
-			hash_value_t next_key(const Job<Time>& j) const
+			// the key after adding the job at the given position
+			hash_value_t next_key(std::size_t idx) const
 			{
-				return get_key() ^ j.get_key();
+				return get_key() ^ job_fingerprint(idx);
 			}
 
 			friend std::ostream& operator<< (std::ostream& stream,
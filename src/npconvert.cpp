@@ -0,0 +1,148 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+
+#include "OptionParser.h"
+
+#include "io.hpp"
+#include "binary_io.hpp"
+#include "mapped_file.hpp"
+
+// Converts CSV or YAML job sets (plus optional precedence and abort
+// files) into the binary job-set format that nptest loads directly.
+
+static bool want_dense;
+
+static bool want_precedence = false;
+static std::string precedence_file;
+
+static bool want_aborts = false;
+static std::string aborts_file;
+
+// the file that is currently being read or written, for error messages
+static std::string current_file;
+
+template<class Time>
+static void convert(const std::string& fname, const std::string& out_name)
+{
+	std::string ext = fname.substr(fname.find_last_of(".") + 1);
+	bool is_yaml = ext == "yaml" || ext == "yml";
+
+	typename NP::Job<Time>::Job_set jobs;
+	NP::Precedence_constraints edges;
+	std::vector<NP::Abort_action<Time>> aborts;
+
+	current_file = fname;
+	if (is_yaml) {
+		auto in = std::ifstream(fname, std::ios::in);
+		if (!in)
+			throw std::ios_base::failure("cannot open " + fname);
+		// never write a partial job set
+		jobs = NP::read_yaml_job_set<Time>(in, edges);
+	} else {
+		NP::Mapped_file in(fname);
+		jobs = NP::parse_csv_job_file<Time>(in.begin(), in.end());
+	}
+
+	if (want_precedence) {
+		current_file = precedence_file;
+		NP::Mapped_file in(precedence_file);
+		auto more = NP::parse_dag_file(in.begin(), in.end());
+		edges.insert(edges.end(), more.begin(), more.end());
+	}
+
+	if (want_aborts) {
+		current_file = aborts_file;
+		NP::Mapped_file in(aborts_file);
+		aborts = NP::parse_abort_file<Time>(in.begin(), in.end());
+	}
+
+	// catch bad references now rather than in every later analysis
+	NP::validate_prec_refs<Time>(edges, jobs);
+	NP::validate_abort_refs<Time>(aborts, jobs);
+
+	current_file = out_name;
+	auto out = std::ofstream(out_name, std::ios::out | std::ios::binary);
+	if (!out)
+		throw std::ios_base::failure("cannot open " + out_name);
+	NP::write_binary_job_set<Time>(out, jobs, edges, aborts);
+}
+
+int main(int argc, char** argv)
+{
+	auto parser = optparse::OptionParser();
+
+	parser.description("Convert job sets into the binary job-set format");
+	parser.usage("usage: %prog [OPTIONS]... -o OUTPUT JOB-SET-FILE");
+
+	parser.add_option("-t", "--time").dest("time_model")
+	      .metavar("TIME-MODEL")
+	      .choices({"dense", "discrete"}).set_default("discrete")
+	      .help("choose 'discrete' or 'dense' time (default: discrete)");
+
+	parser.add_option("-p", "--precedence").dest("precedence_file")
+	      .help("name of the file that contains the job set's precedence DAG")
+	      .set_default("");
+
+	parser.add_option("-a", "--abort-actions").dest("abort_file")
+	      .help("name of the file that contains the job set's abort actions")
+	      .set_default("");
+
+	parser.add_option("-o", "--output").dest("output")
+	      .help("name of the binary job-set file to create (e.g., jobs.npb)")
+	      .set_default("");
+
+	auto options = parser.parse_args(argc, argv);
+
+	want_dense = (const std::string&) options.get("time_model") == "dense";
+
+	want_precedence = options.is_set_by_user("precedence_file");
+	precedence_file = (const std::string&) options.get("precedence_file");
+
+	want_aborts = options.is_set_by_user("abort_file");
+	aborts_file = (const std::string&) options.get("abort_file");
+
+	std::string out_name = (const std::string&) options.get("output");
+
+	if (parser.args().size() != 1 || out_name.empty()) {
+		parser.print_usage(std::cerr);
+		return 1;
+	}
+
+	std::string fname = parser.args()[0];
+
+	try {
+		if (want_dense)
+			convert<dense_t>(fname, out_name);
+		else
+			convert<dtime_t>(fname, out_name);
+	} catch (NP::Parse_error& ex) {
+		std::cerr << current_file << ": parse error in line " << ex.line << std::endl;
+		return 1;
+	} catch (std::ios_base::failure& ex) {
+		std::cerr << current_file
+		          << (current_file == out_name ? ": write error" : ": parse error")
+		          << std::endl;
+		return 1;
+	} catch (YAML::Exception& ex) {
+		std::cerr << current_file << ": parse error: " << ex.what() << std::endl;
+		return 1;
+	} catch (NP::InvalidJobReference& ex) {
+		std::cerr << precedence_file << ": bad job reference: job "
+		          << ex.ref.job << " of task " << ex.ref.task
+		          << " is not part of the job set given in "
+		          << fname << std::endl;
+		return 3;
+	} catch (NP::InvalidAbortParameter& ex) {
+		std::cerr << aborts_file << ": invalid abort parameter: job "
+		          << ex.ref.job << " of task " << ex.ref.task
+		          << " has an impossible abort time (abort before release)"
+		          << std::endl;
+		return 4;
+	} catch (std::exception& ex) {
+		std::cerr << fname << ": '" << ex.what() << "'" << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
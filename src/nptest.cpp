@@ -2,9 +2,28 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <iomanip>
+#include <memory>
+
+#include <cstdio>
+#include <vector>
+#include <unordered_map>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 #ifndef _WIN32
 #include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #endif
 
 #include "OptionParser.h"
@@ -20,9 +39,10 @@
 #endif
 
 #include "problem.hpp"
-#include "uni/space.hpp"
-#include "global/space.hpp"
+#include "analysis.hpp"
 #include "io.hpp"
+#include "binary_io.hpp"
+#include "mapped_file.hpp"
 #include "clock.hpp"
 
 
@@ -53,8 +73,19 @@ static bool want_rta_file;
 
 static bool continue_after_dl_miss = false;
 
+static NP::Merge_strategy merge_strategy = NP::Merge_strategy::hashing;
+static bool want_trusted_fingerprints = false;
+
+static std::size_t frontier_budget = 0;
+static std::string spill_directory;
+
+static std::string checkpoint_file;
+static double checkpoint_interval = 600;
+static bool want_resume = false;
+
 #ifdef CONFIG_PARALLEL
 static unsigned int num_worker_threads = 0;
+static bool want_worker_stats = false;
 #endif
 
 struct Analysis_result {
@@ -64,29 +95,99 @@ struct Analysis_result {
 	double cpu_time;
 	std::string graph;
 	std::string response_times_csv;
+	NP::Workers_stats worker_stats;
+};
+
+// Thrown if an input file cannot be parsed.
+struct File_parse_error {
+	std::string file;
+	unsigned long line;
+};
+
+// Report parse errors of the buffer-based parsers with the name of the
+// file that is being parsed.
+template<class Parse>
+static auto parse_file(const std::string& fname, Parse parse) -> decltype(parse())
+{
+	try {
+		return parse();
+	} catch (NP::Parse_error& ex) {
+		throw File_parse_error{fname, ex.line};
+	}
+}
+
+// The inputs of one analysis. If jobs_data is given, it holds the
+// contents of the CSV or binary job set instead of in; the precedence
+// constraints and abort actions are optional.
+struct Input_files {
+	std::string jobs_name;
+	std::istream* in;
+	const NP::Mapped_file* jobs_data;
+	bool is_yaml;
+	std::string dag_name;
+	const NP::Mapped_file* dag_csv;
+	std::string aborts_name;
+	const NP::Mapped_file* aborts_csv;
 };
 
+// Parse the input files and create the NP scheduling problem description.
+template<class Time>
+static NP::Scheduling_problem<Time> load_problem(const Input_files& input,
+                                                 unsigned int num_processors)
+{
+	typename NP::Job<Time>::Job_set jobs;
+	NP::Precedence_constraints edges;
+	std::vector<NP::Abort_action<Time>> aborts;
+
+	const NP::Mapped_file* jobs_data = input.jobs_data;
+
+	if (jobs_data && NP::is_binary_job_set(jobs_data->begin(), jobs_data->end())) {
+		// binary job sets include their precedence constraints and abort actions
+		auto binary = NP::parse_binary_job_set<Time>(jobs_data->begin(), jobs_data->end());
+		jobs = std::move(binary.jobs);
+		edges = std::move(binary.edges);
+		aborts = std::move(binary.aborts);
+	} else if (input.is_yaml)
+		// YAML job sets include their precedence constraints
+		jobs = NP::parse_yaml_job_set<Time>(*input.in, edges);
+	else
+		jobs = parse_file(input.jobs_name, [&] () {
+			return jobs_data ? NP::parse_csv_job_file<Time>(jobs_data->begin(), jobs_data->end()) :
+				NP::parse_csv_job_file<Time>(*input.in);
+		});
+
+	// Parse precedence constraints
+	if (input.dag_csv && !input.is_yaml) {
+		auto more = parse_file(input.dag_name, [&] () {
+			return NP::parse_dag_file(input.dag_csv->begin(), input.dag_csv->end());
+		});
+		edges.insert(edges.end(), more.begin(), more.end());
+	}
+
+	// Parse abort actions
+	if (input.aborts_csv) {
+		auto more = parse_file(input.aborts_name, [&] () {
+			return NP::parse_abort_file<Time>(input.aborts_csv->begin(), input.aborts_csv->end());
+		});
+		aborts.insert(aborts.end(), more.begin(), more.end());
+	}
+
+	return NP::Scheduling_problem<Time>{std::move(jobs), std::move(edges),
+	                                    std::move(aborts), num_processors};
+}
+
 template<class Time, class Space>
-static Analysis_result analyze(
-	std::istream &in,
-	std::istream &dag_in,
-	std::istream &aborts_in,
-    bool &is_yaml)
+static Analysis_result analyze(const Input_files& input)
 {
 #ifdef CONFIG_PARALLEL
 	oneapi::tbb::task_arena arena(num_worker_threads ? num_worker_threads : oneapi::tbb::info::default_concurrency());
-#endif
-
-	// Parse input files and create NP scheduling problem description
-    typename NP::Job<Time>::Job_set jobs = is_yaml ? NP::parse_yaml_job_file<Time>(in) : NP::parse_csv_job_file<Time>(in);
-	// Parse precedence constraints
-	typename NP::Precedence_constraints edges = is_yaml ? NP::parse_yaml_dag_file(in) : NP::parse_dag_file(dag_in);
 
-	NP::Scheduling_problem<Time> problem{
-        jobs,
-		edges,
-		NP::parse_abort_file<Time>(aborts_in),
-		num_processors};
+	auto problem = arena.execute([&] () {
+		return load_problem<Time>(input, num_processors);
+	});
+#else
+	auto problem = load_problem<Time>(input, num_processors);
+#endif
 
 	// Set common analysis options
 	NP::Analysis_options opts;
@@ -95,9 +196,20 @@ static Analysis_result analyze(
 	opts.early_exit = !continue_after_dl_miss;
 	opts.num_buckets = problem.jobs.size();
 	opts.be_naive = want_naive;
+	opts.merge_strategy = merge_strategy;
+	opts.trust_fingerprints = want_trusted_fingerprints;
+	opts.frontier_budget = frontier_budget;
+	opts.spill_directory = spill_directory;
+	opts.checkpoint_file = checkpoint_file;
+	opts.checkpoint_interval = checkpoint_interval;
+	opts.resume = want_resume;
 
 	// Actually call the analysis engine
+#ifdef CONFIG_PARALLEL
+	auto space = arena.execute([&] () { return Space::explore(problem, opts); });
+#else
 	auto space = Space::explore(problem, opts);
+#endif
 
 	// Extract the analysis results
 	auto graph = std::ostringstream();
@@ -110,8 +222,9 @@ static Analysis_result analyze(
 
 	if (want_rta_file) {
 		rta << "Task ID, Job ID, BCCT, WCCT, BCRT, WCRT" << std::endl;
-		for (const auto& j : problem.jobs) {
-			Interval<Time> finish = space.get_finish_times(j);
+		for (std::size_t i = 0; i < problem.jobs.size(); i++) {
+			const auto& j = problem.jobs[i];
+			Interval<Time> finish = space.get_finish_times(i);
 			rta << j.get_task_id() << ", "
 			    << j.get_job_id() << ", "
 			    << finish.from() << ", "
@@ -133,60 +246,118 @@ static Analysis_result analyze(
 		problem.jobs.size(),
 		space.get_cpu_time(),
 		graph.str(),
-		rta.str()
+		rta.str(),
+		space.get_worker_stats()
 	};
 }
 
-static Analysis_result process_stream(
-	std::istream &in,
-	std::istream &dag_in,
-	std::istream &aborts_in,
-    bool is_yaml)
+// the engine selected on the command line
+static NP::Engine_options command_line_engine()
+{
+	NP::Engine_options engine;
+	if (want_multiprocessor)
+		engine.engine = NP::Analysis_engine::global;
+	else {
+		engine.engine = NP::Analysis_engine::uniprocessor;
+		if (want_prm_iip)
+			engine.iip = NP::Idle_time_policy::precautious_rm;
+		else if (want_cw_iip)
+			engine.iip = NP::Idle_time_policy::critical_window;
+	}
+	return engine;
+}
+
+static Analysis_result process_stream(const Input_files& input)
+{
+	auto engine = command_line_engine();
+
+	if (want_dense)
+		return NP::with_state_space<dense_t>(num_processors, engine, [&] (auto tag) {
+			return analyze<dense_t, typename decltype(tag)::type>(input);
+		});
+	else
+		return NP::with_state_space<dtime_t>(num_processors, engine, [&] (auto tag) {
+			return analyze<dtime_t, typename decltype(tag)::type>(input);
+		});
+}
+
+// peak memory usage of the process (in KiB)
+static long peak_memory_usage()
+{
+#ifdef _WIN32 // rusage does not work under Windows
+	return 0;
+#else
+	struct rusage u;
+	if (getrusage(RUSAGE_SELF, &u) == 0)
+		return u.ru_maxrss;
+	return 0;
+#endif
+}
+
+// print a result row in the format of print_header()
+static void print_result(std::ostream& out, const std::string& name,
+                         const Analysis_result& result,
+                         unsigned int max_depth, unsigned int num_processors)
 {
-	if (want_multiprocessor && want_dense)
-		return analyze<dense_t, NP::Global::State_space<dense_t>>(in, dag_in, aborts_in, is_yaml);
-	else if (want_multiprocessor && !want_dense)
-		return analyze<dtime_t, NP::Global::State_space<dtime_t>>(in, dag_in, aborts_in, is_yaml);
-	else if (want_dense && want_prm_iip)
-		return analyze<dense_t, NP::Uniproc::State_space<dense_t, NP::Uniproc::Precatious_RM_IIP<dense_t>>>(in, dag_in, aborts_in, is_yaml);
-	else if (want_dense && want_cw_iip)
-		return analyze<dense_t, NP::Uniproc::State_space<dense_t, NP::Uniproc::Critical_window_IIP<dense_t>>>(in, dag_in, aborts_in, is_yaml);
-	else if (want_dense && !want_prm_iip)
-		return analyze<dense_t, NP::Uniproc::State_space<dense_t>>(in, dag_in, aborts_in, is_yaml);
-	else if (!want_dense && want_prm_iip)
-		return analyze<dtime_t, NP::Uniproc::State_space<dtime_t, NP::Uniproc::Precatious_RM_IIP<dtime_t>>>(in, dag_in, aborts_in, is_yaml);
-	else if (!want_dense && want_cw_iip)
-		return analyze<dtime_t, NP::Uniproc::State_space<dtime_t, NP::Uniproc::Critical_window_IIP<dtime_t>>>(in, dag_in, aborts_in, is_yaml);
+	out << name;
+
+	if (max_depth && max_depth < result.number_of_jobs)
+		// mark result as invalid due to debug abort
+		out << ",  X";
 	else
-		return analyze<dtime_t, NP::Uniproc::State_space<dtime_t>>(in, dag_in, aborts_in, is_yaml);
+		out << ",  " << (int) result.schedulable;
+
+	out << ",  " << result.number_of_jobs
+	    << ",  " << result.number_of_states
+	    << ",  " << result.number_of_edges
+	    << ",  " << result.max_width
+	    << ",  " << std::fixed << result.cpu_time
+	    << ",  " << ((double) peak_memory_usage()) / (1024.0)
+	    << ",  " << (int) result.timeout
+	    << ",  " << num_processors
+	    << std::endl;
 }
 
+#ifdef CONFIG_PARALLEL
+static void print_worker_stats(const NP::Workers_stats& stats)
+{
+	double busy = 0, total = 0;
+	for (unsigned int i = 0; i < stats.size(); i++) {
+		std::cerr << "# worker " << i
+		          << ": busy " << std::fixed << std::setprecision(6)
+		          << stats[i].busy << "s"
+		          << ", idle " << stats[i].idle << "s"
+		          << ", " << stats[i].num_states << " states"
+		          << std::endl;
+		busy += stats[i].busy;
+		total += stats[i].busy + stats[i].idle;
+	}
+	if (total > 0)
+		std::cerr << "# parallel efficiency: "
+		          << std::setprecision(1) << 100 * busy / total << "%"
+		          << std::endl;
+}
+#endif
+
 static void process_file(const std::string& fname)
 {
 	try {
 		Analysis_result result;
 
-		auto empty_dag_stream = std::istringstream("\n");
-		auto empty_aborts_stream = std::istringstream("\n");
-		auto dag_stream = std::ifstream();
-		auto aborts_stream = std::ifstream();
+		std::unique_ptr<NP::Mapped_file> dag_csv, aborts_csv;
 
 		if (want_precedence)
-			dag_stream.open(precedence_file);
+			dag_csv.reset(new NP::Mapped_file(precedence_file));
 
 		if (want_aborts)
-			aborts_stream.open(aborts_file);
+			aborts_csv.reset(new NP::Mapped_file(aborts_file));
 
-		std::istream &dag_in = want_precedence ?
-			static_cast<std::istream&>(dag_stream) :
-			static_cast<std::istream&>(empty_dag_stream);
-
-		std::istream &aborts_in = want_aborts ?
-			static_cast<std::istream&>(aborts_stream) :
-			static_cast<std::istream&>(empty_aborts_stream);
+		Input_files input{fname, &std::cin, nullptr, false,
+		                  precedence_file, dag_csv.get(),
+		                  aborts_file, aborts_csv.get()};
 
 		if (fname == "-")
-			result = process_stream(std::cin, dag_in, aborts_in, false);
+			result = process_stream(input);
 		else {
             // check the extension of the file
             std::string ext = fname.substr(fname.find_last_of(".") + 1);
@@ -195,8 +366,16 @@ static void process_file(const std::string& fname)
                 is_yaml = true;
             }
 
-			auto in = std::ifstream(fname, std::ios::in);
-			result = process_stream(in, dag_in, aborts_in, is_yaml);
+			if (is_yaml) {
+				auto in = std::ifstream(fname, std::ios::in);
+				input.in = &in;
+				input.is_yaml = true;
+				result = process_stream(input);
+			} else {
+				NP::Mapped_file jobs_data(fname);
+				input.jobs_data = &jobs_data;
+				result = process_stream(input);
+			}
 #ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
 			if (want_dot_graph) {
 				std::string dot_name = fname;
@@ -211,7 +390,7 @@ static void process_file(const std::string& fname)
 #endif
 			if (want_rta_file) {
 				std::string rta_name = fname;
-				auto p = is_yaml ? rta_name.find(".yaml") : rta_name.find(".csv");
+				auto p = rta_name.find(is_yaml ? ".yaml" : ext == "npb" ? ".npb" : ".csv");
 				if (p != std::string::npos) {
 					rta_name.replace(p, std::string::npos, ".rta.csv");
 					auto out  = std::ofstream(rta_name,  std::ios::out);
@@ -221,32 +400,15 @@ static void process_file(const std::string& fname)
 			}
 		}
 
-#ifdef _WIN32 // rusage does not work under Windows
-		long mem_used = 0;
-#else
-		struct rusage u;
-		long mem_used = 0;
-		if (getrusage(RUSAGE_SELF, &u) == 0)
-			mem_used = u.ru_maxrss;
-#endif
-
-		std::cout << fname;
+		print_result(std::cout, fname, result, max_depth, num_processors);
 
-		if (max_depth && max_depth < result.number_of_jobs)
-			// mark result as invalid due to debug abort
-			std::cout << ",  X";
-		else
-			std::cout << ",  " << (int) result.schedulable;
-
-		std::cout << ",  " << result.number_of_jobs
-		          << ",  " << result.number_of_states
-		          << ",  " << result.number_of_edges
-		          << ",  " << result.max_width
-		          << ",  " << std::fixed << result.cpu_time
-		          << ",  " << ((double) mem_used) / (1024.0)
-		          << ",  " << (int) result.timeout
-		          << ",  " << num_processors
-		          << std::endl;
+#ifdef CONFIG_PARALLEL
+		if (want_worker_stats)
+			print_worker_stats(result.worker_stats);
+#endif
+	} catch (File_parse_error& ex) {
+		std::cerr << ex.file << ": parse error in line " << ex.line << std::endl;
+		exit(1);
 	} catch (std::ios_base::failure& ex) {
 		std::cerr << fname;
 		if (want_precedence)
@@ -272,6 +434,505 @@ static void process_file(const std::string& fname)
 	}
 }
 
+#ifndef _WIN32
+// Analyze the given files in up to max_children child processes at a
+// time. Each child analyzes a single file, so that the reported CPU time
+// and peak memory usage refer to that file only, and so that an invalid
+// file does not stop the analysis of the others. The results are printed
+// in the order of the files. Returns the exit status of the first file
+// that could not be analyzed, or zero.
+static int process_files_in_batch(const std::vector<std::string>& fnames,
+                                  unsigned int max_children)
+{
+	struct Child {
+		FILE* out;
+		int status;
+		bool done;
+	};
+
+	std::vector<Child> children(fnames.size(), Child{nullptr, 0, false});
+	std::unordered_map<pid_t, std::size_t> running;
+	std::size_t next = 0, printed = 0;
+	int result = 0;
+
+	while (printed < fnames.size()) {
+		// the output of a child is buffered until all earlier files are
+		// done, so don't run too far ahead of a slow file
+		while (next < fnames.size() && running.size() < max_children
+		       && next - printed < 4 * std::size_t(max_children)) {
+			FILE* out = std::tmpfile();
+			// don't let the child inherit unflushed output
+			std::fflush(stdout);
+			pid_t pid = out ? fork() : -1;
+			if (pid < 0) {
+				std::perror("nptest: cannot start batch worker");
+				exit(1);
+			}
+			if (pid == 0) {
+				dup2(fileno(out), STDOUT_FILENO);
+				process_file(fnames[next]);
+				std::cout.flush();
+				exit(0);
+			}
+			children[next].out = out;
+			running[pid] = next++;
+		}
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			std::perror("nptest: waiting for batch worker");
+			exit(1);
+		}
+		auto r = running.find(pid);
+		if (r == running.end())
+			continue;
+		children[r->second].status = status;
+		children[r->second].done = true;
+		running.erase(r);
+
+		for (; printed < next && children[printed].done; printed++) {
+			Child& c = children[printed];
+			char buffer[4096];
+			std::size_t n;
+			std::rewind(c.out);
+			while ((n = std::fread(buffer, 1, sizeof(buffer), c.out)) > 0)
+				std::fwrite(buffer, 1, n, stdout);
+			std::fclose(c.out);
+
+			int code = 1;
+			if (WIFEXITED(c.status))
+				code = WEXITSTATUS(c.status);
+			else
+				std::cerr << fnames[printed] << ": analysis terminated by signal "
+				          << WTERMSIG(c.status) << std::endl;
+			if (code && !result)
+				result = code;
+		}
+		std::fflush(stdout);
+	}
+
+	return result;
+}
+#endif
+
+#ifndef _WIN32
+// Server mode
+// ===========
+//
+// In server mode, nptest answers a stream of analysis requests without
+// paying process startup for each of them. Every request is a single line
+// holding a YAML flow map (e.g., a JSON object) such as
+//
+//     {"id": "run-17", "jobs": "jobs.csv", "multiprocessor": 2}
+//
+// and is answered by a single line in the format of print_header(), whose
+// first column is the request's id, or by "<id>,  E,  <error message>".
+// Requests are analyzed concurrently, so responses may arrive out of order.
+
+// the options of a single request
+struct Server_request {
+	std::string id;
+	std::string jobs_file;
+	std::string jobset; // inline CSV job set
+	std::string precedence_file;
+	std::string aborts_file;
+	bool dense;
+	NP::Engine_options engine;
+	unsigned int num_processors;
+	double timeout;
+	unsigned int max_depth;
+	bool naive;
+	bool continue_after_dl_miss;
+};
+
+// Parse a request line. Options that a request does not mention default
+// to those given on the command line. Sets r.id before anything else, so
+// that even a malformed request can be answered under its id.
+static void parse_request(const std::string& line, Server_request& r)
+{
+	r.dense = want_dense;
+	r.engine = command_line_engine();
+	r.num_processors = num_processors;
+	r.timeout = timeout;
+	r.max_depth = max_depth;
+	r.naive = want_naive;
+	r.continue_after_dl_miss = continue_after_dl_miss;
+
+	YAML::Node request = YAML::Load(line);
+	if (!request.IsMap())
+		throw std::invalid_argument("a request must be a map");
+
+	if (request["id"])
+		r.id = request["id"].as<std::string>();
+
+	bool want_iip = false;
+
+	for (const auto& option : request) {
+		auto key = option.first.as<std::string>();
+		const auto& value = option.second;
+
+		if (key == "id")
+			continue;
+		else if (key == "jobs")
+			r.jobs_file = value.as<std::string>();
+		else if (key == "jobset")
+			r.jobset = value.as<std::string>();
+		else if (key == "precedence")
+			r.precedence_file = value.as<std::string>();
+		else if (key == "abort-actions")
+			r.aborts_file = value.as<std::string>();
+		else if (key == "time") {
+			auto model = value.as<std::string>();
+			if (model != "dense" && model != "discrete")
+				throw std::invalid_argument("invalid time model '" + model + "'");
+			r.dense = model == "dense";
+		} else if (key == "iip") {
+			auto iip = value.as<std::string>();
+			if (iip == "none")
+				r.engine.iip = NP::Idle_time_policy::none;
+			else if (iip == "P-RM")
+				r.engine.iip = NP::Idle_time_policy::precautious_rm;
+			else if (iip == "CW")
+				r.engine.iip = NP::Idle_time_policy::critical_window;
+			else
+				throw std::invalid_argument("invalid IIP '" + iip + "'");
+			want_iip = true;
+		} else if (key == "multiprocessor") {
+			r.num_processors = value.as<unsigned int>();
+			if (!r.num_processors || r.num_processors > MAX_PROCESSORS)
+				throw std::invalid_argument("invalid number of processors");
+			r.engine.engine = NP::Analysis_engine::global;
+		} else if (key == "time-limit")
+			r.timeout = value.as<double>();
+		else if (key == "depth-limit") {
+			r.max_depth = value.as<unsigned int>();
+			if (r.max_depth <= 1)
+				throw std::invalid_argument("invalid depth limit");
+			r.max_depth -= 1;
+		} else if (key == "naive")
+			r.naive = value.as<bool>();
+		else if (key == "continue-after-deadline-miss")
+			r.continue_after_dl_miss = value.as<bool>();
+		else
+			throw std::invalid_argument("unknown option '" + key + "'");
+	}
+
+	if (r.jobs_file.empty() == r.jobset.empty())
+		throw std::invalid_argument("a request needs either 'jobs' or 'jobset'");
+
+	// an IIP given on the command line does not apply to global requests
+	if (r.engine.engine == NP::Analysis_engine::global && !want_iip)
+		r.engine.iip = NP::Idle_time_policy::none;
+}
+
+template<class Time>
+static Analysis_result serve_request(const Server_request& r)
+{
+	std::unique_ptr<NP::Mapped_file> jobs_data, dag_csv, aborts_csv;
+	std::ifstream yaml_in;
+	std::istringstream inline_in(r.jobset);
+
+	Input_files input{r.jobs_file.empty() ? "jobset" : r.jobs_file,
+	                  &inline_in, nullptr, false,
+	                  r.precedence_file, nullptr,
+	                  r.aborts_file, nullptr};
+
+	if (!r.jobs_file.empty()) {
+		std::string ext = r.jobs_file.substr(r.jobs_file.find_last_of(".") + 1);
+		input.is_yaml = ext == "yaml" || ext == "yml";
+		if (input.is_yaml) {
+			yaml_in.open(r.jobs_file);
+			if (!yaml_in)
+				throw std::ios_base::failure("cannot open " + r.jobs_file);
+			input.in = &yaml_in;
+		} else {
+			jobs_data.reset(new NP::Mapped_file(r.jobs_file));
+			input.jobs_data = jobs_data.get();
+		}
+	}
+
+	if (!r.precedence_file.empty()) {
+		dag_csv.reset(new NP::Mapped_file(r.precedence_file));
+		input.dag_csv = dag_csv.get();
+	}
+
+	if (!r.aborts_file.empty()) {
+		aborts_csv.reset(new NP::Mapped_file(r.aborts_file));
+		input.aborts_csv = aborts_csv.get();
+	}
+
+	auto problem = load_problem<Time>(input, r.num_processors);
+
+	NP::Analysis_options opts;
+	opts.timeout = r.timeout;
+	opts.max_depth = r.max_depth;
+	opts.early_exit = !r.continue_after_dl_miss;
+	opts.num_buckets = problem.jobs.size();
+	opts.be_naive = r.naive;
+	opts.merge_strategy = merge_strategy;
+	opts.trust_fingerprints = want_trusted_fingerprints;
+	opts.frontier_budget = frontier_budget;
+	opts.spill_directory = spill_directory;
+
+	auto results = NP::analyze(problem, opts, r.engine);
+
+	Analysis_result result;
+	result.schedulable = results.schedulable;
+	result.timeout = results.timed_out;
+	result.number_of_states = results.number_of_states;
+	result.number_of_edges = results.number_of_edges;
+	result.max_width = results.max_width;
+	result.number_of_jobs = problem.jobs.size();
+	result.cpu_time = results.cpu_time;
+	return result;
+}
+
+// Analyze the request in the given line and return the response line.
+static std::string handle_request(const std::string& line)
+{
+	Server_request r;
+	std::ostringstream response;
+
+	auto name = [&r] () {
+		return !r.id.empty() ? r.id : !r.jobs_file.empty() ? r.jobs_file : "-";
+	};
+
+	auto error = [&] (const std::string& msg) {
+		response << name() << ",  E,  " << msg << std::endl;
+		return response.str();
+	};
+
+	try {
+		parse_request(line, r);
+		auto result = r.dense ? serve_request<dense_t>(r) : serve_request<dtime_t>(r);
+		print_result(response, name(), result, r.max_depth, r.num_processors);
+		return response.str();
+	} catch (File_parse_error& ex) {
+		return error(ex.file + ": parse error in line " + std::to_string(ex.line));
+	} catch (NP::InvalidJobReference& ex) {
+		return error("bad job reference: job " + std::to_string(ex.ref.job)
+		             + " of task " + std::to_string(ex.ref.task)
+		             + " is not part of the job set");
+	} catch (NP::InvalidAbortParameter& ex) {
+		return error("invalid abort parameter: job " + std::to_string(ex.ref.job)
+		             + " of task " + std::to_string(ex.ref.task)
+		             + " has an impossible abort time (abort before release)");
+	} catch (std::exception& ex) {
+		return error(ex.what());
+	}
+}
+
+// A client of the server: requests are read line by line from in_fd, and
+// responses are written to out_fd as whole lines.
+class Server_client {
+	public:
+
+	Server_client(int in_fd, int out_fd, bool owns_fds)
+	: in_fd(in_fd), out_fd(out_fd), owns_fds(owns_fds), pos(0)
+	{
+	}
+
+	~Server_client()
+	{
+		if (owns_fds) {
+			close(in_fd);
+			if (out_fd != in_fd)
+				close(out_fd);
+		}
+	}
+
+	// returns false at the end of the input
+	bool read_line(std::string& line)
+	{
+		for (;;) {
+			auto eol = buffer.find('\n', pos);
+			if (eol != std::string::npos) {
+				line.assign(buffer, pos, eol - pos);
+				pos = eol + 1;
+				break;
+			}
+			buffer.erase(0, pos);
+			pos = 0;
+
+			char chunk[4096];
+			ssize_t n = read(in_fd, chunk, sizeof(chunk));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0) {
+				if (buffer.empty())
+					return false;
+				line.swap(buffer);
+				buffer.clear();
+				break;
+			}
+			buffer.append(chunk, n);
+		}
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		return true;
+	}
+
+	void write_line(const std::string& line)
+	{
+		std::lock_guard<std::mutex> guard(out_lock);
+		const char* data = line.data();
+		std::size_t left = line.size();
+		while (left) {
+			ssize_t n = write(out_fd, data, left);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+				// the client has gone away
+				return;
+			data += n;
+			left -= n;
+		}
+	}
+
+	private:
+
+	int in_fd, out_fd;
+	bool owns_fds;
+	std::string buffer;
+	std::size_t pos;
+	std::mutex out_lock;
+};
+
+struct Server_task {
+	std::shared_ptr<Server_client> client;
+	std::string request;
+};
+
+// the requests that wait for an idle worker thread
+class Request_queue {
+	public:
+
+	void push(Server_task task)
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			tasks.push_back(std::move(task));
+		}
+		ready.notify_one();
+	}
+
+	// blocks until a request is available; returns false once the queue
+	// has been closed and drained
+	bool pop(Server_task& task)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		ready.wait(guard, [this] () { return closed || !tasks.empty(); });
+		if (tasks.empty())
+			return false;
+		task = std::move(tasks.front());
+		tasks.pop_front();
+		return true;
+	}
+
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			closed = true;
+		}
+		ready.notify_all();
+	}
+
+	private:
+
+	std::deque<Server_task> tasks;
+	std::mutex lock;
+	std::condition_variable ready;
+	bool closed = false;
+};
+
+static int listen_on(const std::string& path)
+{
+	struct sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << path << ": socket path too long" << std::endl;
+		return -1;
+	}
+	std::strcpy(addr.sun_path, path.c_str());
+
+	// replace the socket of an earlier server, but nothing else
+	struct stat st;
+	if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path.c_str());
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0
+	    || bind(fd, (struct sockaddr*) &addr, sizeof(addr)) < 0
+	    || listen(fd, SOMAXCONN) < 0) {
+		std::perror(("nptest: " + path).c_str());
+		if (fd >= 0)
+			close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+// Answer requests from standard input, or from the clients of the Unix
+// domain socket at socket_path if it is not empty, with num_workers
+// analyses running at a time. Returns once standard input is exhausted;
+// a socket server runs until it is killed.
+static int run_server(const std::string& socket_path, unsigned int num_workers)
+{
+	// don't die if a client disconnects before its response is written
+	signal(SIGPIPE, SIG_IGN);
+
+	// open the socket before starting any threads, so that errors are
+	// reported right away
+	int listen_fd = -1;
+	if (!socket_path.empty()) {
+		listen_fd = listen_on(socket_path);
+		if (listen_fd < 0)
+			return 1;
+	}
+
+	Request_queue queue;
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 0; i < num_workers; i++)
+		workers.emplace_back([&queue] () {
+			Server_task task;
+			while (queue.pop(task)) {
+				task.client->write_line(handle_request(task.request));
+				task.client.reset();
+			}
+		});
+
+	auto read_requests = [&queue] (std::shared_ptr<Server_client> client) {
+		std::string line;
+		while (client->read_line(line))
+			if (line.find_first_not_of(" \t") != std::string::npos)
+				queue.push(Server_task{client, line});
+	};
+
+	if (listen_fd < 0) {
+		read_requests(std::make_shared<Server_client>(STDIN_FILENO, STDOUT_FILENO, false));
+		queue.close();
+		for (auto& w : workers)
+			w.join();
+		return 0;
+	}
+
+	for (;;) {
+		int fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			std::perror("nptest: accept");
+			exit(1);
+		}
+		std::thread(read_requests, std::make_shared<Server_client>(fd, fd, true)).detach();
+	}
+}
+#endif
+
 static void print_header(){
 	std::cout << "# file name"
 	          << ", schedulable?"
@@ -310,6 +971,17 @@ int main(int argc, char** argv)
 	      .action("store_const").set_const("1")
 	      .help("use the naive exploration method (default: merging)");
 
+	parser.add_option("--merge").dest("merge")
+	      .choices({"hash", "sort"}).set_default("hash")
+	      .help("find states to merge by hashing each new state, or by "
+	            "sorting each depth's states (global analysis only; "
+	            "default: hash)");
+
+	parser.add_option("--trust-fingerprints").dest("trust_fingerprints")
+	      .action("store_const").set_const("1").set_default("0")
+	      .help("merge states with equal 128-bit fingerprints without "
+	            "comparing their scheduled jobs (global analysis only)");
+
 	parser.add_option("-i", "--iip").dest("iip")
 	      .choices({"none", "P-RM", "CW"}).set_default("none")
 	      .help("the IIP to use (default: none)");
@@ -330,6 +1002,58 @@ int main(int argc, char** argv)
 	      .help("set the number of worker threads (parallel analysis)")
 	      .set_default("0");
 
+	parser.add_option("--worker-stats").dest("worker_stats")
+	      .help("report how busy each worker thread was (parallel analysis)")
+	      .action("store_const").set_const("1")
+	      .set_default("0");
+
+	parser.add_option("--frontier-budget").dest("frontier_budget")
+	      .metavar("N")
+	      .help("keep at most N states of the next depth in memory and "
+	            "spill the others to disk (global analysis only; "
+	            "default: 0, unlimited)")
+	      .set_default("0");
+
+	parser.add_option("--spill-dir").dest("spill_dir")
+	      .metavar("DIR")
+	      .help("directory for spilled states (default: the system's "
+	            "temporary directory)")
+	      .set_default("");
+
+	parser.add_option("--checkpoint").dest("checkpoint")
+	      .metavar("FILE")
+	      .help("periodically save the progress of the analysis to FILE")
+	      .set_default("");
+
+	parser.add_option("--checkpoint-interval").dest("checkpoint_interval")
+	      .metavar("SECONDS")
+	      .help("how often to save a checkpoint (default: 600)")
+	      .set_default("600");
+
+	parser.add_option("--resume").dest("resume")
+	      .help("continue from the checkpoint file, if it exists")
+	      .action("store_const").set_const("1")
+	      .set_default("0");
+
+	parser.add_option("-b", "--batch").dest("batch")
+	      .metavar("N")
+	      .help("analyze up to N job-set files concurrently, "
+	            "each in a separate process (default: 1); in server mode, "
+	            "the number of analysis threads (default: number of CPUs)")
+	      .set_default("1");
+
+	parser.add_option("--server").dest("server")
+	      .help("read analysis requests line by line from standard input "
+	            "and answer each with a result line")
+	      .action("store_const").set_const("1")
+	      .set_default("0");
+
+	parser.add_option("--socket").dest("socket")
+	      .metavar("PATH")
+	      .help("in server mode, accept requests on the Unix domain "
+	            "socket PATH instead of standard input")
+	      .set_default("");
+
 	parser.add_option("--header").dest("print_header")
 	      .help("print a column header")
 	      .action("store_const").set_const("1")
@@ -361,6 +1085,10 @@ int main(int argc, char** argv)
 
 	want_naive = options.get("naive");
 
+	const std::string& merge = options.get("merge");
+	if (merge == "sort")
+		merge_strategy = NP::Merge_strategy::sorting;
+
 	timeout = options.get("timeout");
 
 	max_depth = options.get("depth");
@@ -412,8 +1140,10 @@ int main(int argc, char** argv)
 
 #ifdef CONFIG_PARALLEL
 	num_worker_threads = options.get("num_threads");
+	want_worker_stats = options.get("worker_stats");
 #else
-	if (options.is_set_by_user("num_threads")) {
+	if (options.is_set_by_user("num_threads")
+	    || options.is_set_by_user("worker_stats")) {
 		std::cerr << "Error: parallel analysis must be enabled "
 		          << "during compilation (CONFIG_PARALLEL "
 		          << "is not set)." << std::endl;
@@ -421,14 +1151,117 @@ int main(int argc, char** argv)
 	}
 #endif
 
+	if (merge_strategy == NP::Merge_strategy::sorting) {
+#ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
+		std::cerr << "Error: merging by sorting is not supported by builds "
+		          << "that collect the schedule graph." << std::endl;
+		return 2;
+#endif
+		if (!want_multiprocessor) {
+			std::cerr << "Error: merging by sorting is supported only by the "
+			          << "global analysis (-m)." << std::endl;
+			return 1;
+		}
+	}
+
+	want_trusted_fingerprints = options.get("trust_fingerprints");
+	if (want_trusted_fingerprints && !want_multiprocessor) {
+		std::cerr << "Error: --trust-fingerprints is supported only by the "
+		          << "global analysis (-m)." << std::endl;
+		return 1;
+	}
+
+	frontier_budget = (unsigned long) options.get("frontier_budget");
+	spill_directory = (const std::string&) options.get("spill_dir");
+	if (frontier_budget || options.is_set_by_user("spill_dir")) {
+#if defined(CONFIG_PARALLEL) || defined(CONFIG_COLLECT_SCHEDULE_GRAPH)
+		std::cerr << "Error: spilling states is not supported by parallel "
+		          << "builds or builds that collect the schedule graph."
+		          << std::endl;
+		return 3;
+#else
+		if (!want_multiprocessor) {
+			std::cerr << "Error: spilling states is supported only by the "
+			          << "global analysis (-m)." << std::endl;
+			return 1;
+		}
+#endif
+	}
+
+	checkpoint_file = (const std::string&) options.get("checkpoint");
+	checkpoint_interval = options.get("checkpoint_interval");
+	want_resume = options.get("resume");
+	if (want_resume && checkpoint_file.empty()) {
+		std::cerr << "Error: --resume requires a checkpoint file (--checkpoint)."
+		          << std::endl;
+		return 1;
+	}
+	if (!checkpoint_file.empty()) {
+#ifdef CONFIG_COLLECT_SCHEDULE_GRAPH
+		std::cerr << "Error: checkpoints are not supported by builds that "
+		          << "collect the schedule graph." << std::endl;
+		return 2;
+#endif
+		if (parser.args().size() != 1 || options.get("server")
+		    || options.is_set_by_user("socket")) {
+			std::cerr << "Error: a checkpoint can be taken only when "
+			          << "analyzing a single job-set file." << std::endl;
+			return 1;
+		}
+	}
+
+	unsigned int batch = options.get("batch");
+	if (!batch) {
+		std::cerr << "Error: invalid batch size\n" << std::endl;
+		return 1;
+	}
+#ifdef _WIN32
+	if (batch > 1) {
+		std::cerr << "[!!] Warning: batch mode is not supported under "
+		          << "Windows; analyzing one file at a time." << std::endl;
+		batch = 1;
+	}
+#endif
+
+	bool want_server = options.get("server");
+	std::string socket_path = (const std::string&) options.get("socket");
+	if (!socket_path.empty())
+		want_server = true;
+
+	if (want_server) {
+#ifdef _WIN32
+		std::cerr << "Error: server mode is not supported under Windows."
+		          << std::endl;
+		return 1;
+#else
+		if (!parser.args().empty() || want_rta_file
+		    || options.is_set_by_user("dot")) {
+			std::cerr << "Error: server mode takes neither job-set files "
+			          << "nor output options." << std::endl;
+			return 1;
+		}
+		if (!options.is_set_by_user("batch"))
+			batch = std::max(1u, std::thread::hardware_concurrency());
+		if (options.get("print_header"))
+			print_header();
+		return run_server(socket_path, batch);
+#endif
+	}
+
 	if (options.get("print_header"))
 		print_header();
 
-	for (auto f : parser.args())
-		process_file(f);
+	std::vector<std::string> fnames = parser.args();
+	if (fnames.empty())
+		fnames.push_back("-");
 
-	if (parser.args().empty())
-		process_file("-");
+#ifndef _WIN32
+	if (batch > 1 && fnames.size() > 1)
+		return process_files_in_batch(fnames, batch);
+#endif
+
+	for (auto f : fnames)
+		process_file(f);
 
 	return 0;
 }
@@ -0,0 +1,151 @@
+#include "doctest.h"
+
+#include <cstdio>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "io.hpp"
+#include "analysis.hpp"
+#include "arena.hpp"
+
+using namespace NP;
+
+static const std::string fig1a_jobs =
+"Task ID, Job ID, Arrival min, Arrival max, Cost min, Cost max, Deadline, Priority\n"
+"1, 1,  0,  0, 1,  2, 10, 10\n"
+"1, 2, 10, 10, 1,  2, 20, 20\n"
+"1, 3, 20, 20, 1,  2, 30, 30\n"
+"1, 4, 30, 30, 1,  2, 40, 40\n"
+"1, 5, 40, 40, 1,  2, 50, 50\n"
+"1, 6, 50, 50, 1,  2, 60, 60\n"
+"2, 7,  0,  0, 7,  8, 30, 30\n"
+"2, 8, 30, 30, 7,  7, 60, 60\n"
+"3, 9,  0,  0, 3, 13, 60, 60\n";
+
+static Scheduling_problem<dtime_t> fig1a_problem(unsigned int num_cpus)
+{
+	auto in = std::istringstream(fig1a_jobs);
+	return Scheduling_problem<dtime_t>{parse_csv_job_file<dtime_t>(in), num_cpus};
+}
+
+TEST_CASE("[api] choose the engine") {
+	auto uni = analyze(fig1a_problem(1));
+	CHECK_FALSE(uni.schedulable);
+	CHECK(uni.finish_times.size() == 9);
+	CHECK(uni.finish_times[1].max() == 24);
+
+	auto global = analyze(fig1a_problem(2));
+	CHECK(global.schedulable);
+	CHECK(global.number_of_states > 0);
+
+	Engine_options cw;
+	cw.iip = Idle_time_policy::critical_window;
+	CHECK_THROWS_AS(analyze(fig1a_problem(2), Analysis_options(), cw),
+	                std::invalid_argument);
+
+	Engine_options forced_global;
+	forced_global.engine = Analysis_engine::global;
+	CHECK_FALSE(analyze(fig1a_problem(1), Analysis_options(), forced_global).schedulable);
+}
+
+TEST_CASE("[api] concurrent analyses") {
+	auto expected = analyze(fig1a_problem(2));
+
+	std::vector<Analysis_results<dtime_t>> results(4);
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < results.size(); i++)
+		threads.emplace_back([&results, i] () {
+			results[i] = analyze(fig1a_problem(2));
+		});
+	for (auto& t : threads)
+		t.join();
+
+	for (const auto& r : results) {
+		CHECK(r.schedulable == expected.schedulable);
+		CHECK(r.number_of_states == expected.number_of_states);
+		CHECK(r.number_of_edges == expected.number_of_edges);
+		CHECK(r.finish_times == expected.finish_times);
+	}
+}
+
+TEST_CASE("[api] arena chunks are recycled") {
+	auto& pool = Arena_chunk_pool::instance();
+	// larger than the chunks that arenas allocate by themselves, which
+	// may still be pooled from earlier tests
+	const std::size_t odd_size = 3000001;
+
+	char* mem = static_cast<char*>(::operator new(odd_size));
+	pool.give(mem, odd_size);
+
+	std::size_t size = 0;
+	CHECK(pool.take(odd_size, size) == mem);
+	CHECK(size == odd_size);
+	pool.give(mem, odd_size);
+
+	// chunks that are much too large are not handed out
+	std::size_t other_size = 0;
+	char* other = pool.take(odd_size / 4, other_size);
+	CHECK(other != mem);
+	if (other)
+		pool.give(other, other_size);
+}
+
+TEST_CASE("[api] finish times by position and by job") {
+	auto problem = fig1a_problem(1);
+	auto space = Uniproc::State_space<dtime_t>::explore(problem, Analysis_options());
+
+	auto copy = problem.jobs;
+	for (std::size_t i = 0; i < problem.jobs.size(); i++) {
+		CHECK(space.get_finish_times(i) == space.get_finish_times(problem.jobs[i]));
+		// jobs outside of the analyzed workload are found by ID
+		CHECK(space.get_finish_times(i) == space.get_finish_times(copy[i]));
+	}
+}
+
+#ifndef CONFIG_COLLECT_SCHEDULE_GRAPH
+TEST_CASE("[api] resume from a checkpoint") {
+	const char* fname = "api-test.checkpoint";
+
+	for (unsigned int num_cpus : {1u, 2u}) {
+		Analysis_options opts;
+		// let the uniprocessor analysis explore everything
+		opts.early_exit = num_cpus > 1;
+		auto expected = analyze(fig1a_problem(num_cpus), opts);
+
+		// stop early, leaving a checkpoint of the next depth behind
+		opts.checkpoint_file = fname;
+		opts.checkpoint_interval = 0;
+		opts.max_depth = 4;
+		auto partial = analyze(fig1a_problem(num_cpus), opts);
+		CHECK(partial.number_of_states < expected.number_of_states);
+
+		opts.max_depth = 0;
+		opts.resume = true;
+		auto resumed = analyze(fig1a_problem(num_cpus), opts);
+		CHECK(resumed.schedulable == expected.schedulable);
+		CHECK(resumed.number_of_states == expected.number_of_states);
+		CHECK(resumed.number_of_edges == expected.number_of_edges);
+		CHECK(resumed.max_width == expected.max_width);
+		CHECK(resumed.finish_times == expected.finish_times);
+	}
+
+	// a checkpoint must not be resumed by a different analysis
+	Analysis_options opts;
+	opts.checkpoint_file = fname;
+	opts.resume = true;
+	opts.be_naive = true;
+	CHECK_THROWS_AS(analyze(fig1a_problem(2), opts), std::runtime_error);
+
+	// nor for a problem that differs only in the bounds of a job
+	std::string jobs = fig1a_jobs;
+	auto pos = jobs.find("3, 13, 60");
+	jobs.replace(pos, 9, "3, 12, 60");
+	auto in = std::istringstream(jobs);
+	Scheduling_problem<dtime_t> changed{parse_csv_job_file<dtime_t>(in), 2};
+	opts.be_naive = false;
+	CHECK_THROWS_AS(analyze(changed, opts), std::runtime_error);
+
+	std::remove(fname);
+}
+#endif
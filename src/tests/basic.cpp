@@ -6,6 +6,8 @@
 
 #include "index_set.hpp"
 #include "jobs.hpp"
+#include "time_index.hpp"
+#include "radix_sort.hpp"
 #include "uni/space.hpp"
 
 using namespace NP;
@@ -70,6 +72,62 @@ TEST_CASE("Interval LUT") {
 	CHECK(count == 1);
 }
 
+TEST_CASE("[basic] time index") {
+	std::vector<Job<dtime_t>> jobs;
+	for (unsigned long i = 0; i < 20; i++) {
+		dtime_t r = (i * 7) % 5;
+		jobs.push_back(Job<dtime_t>{i, Interval<dtime_t>(r, r + 1), Interval<dtime_t>(1, 2), 10, 10});
+	}
+
+	Time_index<dtime_t> by_arrival(jobs, &Job<dtime_t>::earliest_arrival);
+	REQUIRE(by_arrival.size() == jobs.size());
+
+	// sorted by key, ties in workload order
+	for (std::size_t i = 1; i < by_arrival.size(); i++) {
+		CHECK(by_arrival[i - 1].key <= by_arrival[i].key);
+		if (by_arrival[i - 1].key == by_arrival[i].key)
+			CHECK(by_arrival[i - 1].job < by_arrival[i].job);
+	}
+
+	std::vector<dtime_t> keys;
+	for (const auto& e : by_arrival) {
+		CHECK(e.key == jobs[e.job].earliest_arrival());
+		keys.push_back(e.key);
+	}
+
+	for (dtime_t t = -1; t <= 5; t++)
+		for (std::size_t from = 0; from <= keys.size(); from++) {
+			auto lb = std::lower_bound(keys.begin() + from, keys.end(), t) - keys.begin();
+			auto ub = std::upper_bound(keys.begin() + from, keys.end(), t) - keys.begin();
+			CHECK(by_arrival.lower_bound(t, from) - by_arrival.begin() == lb);
+			CHECK(by_arrival.upper_bound(t, from) - by_arrival.begin() == ub);
+		}
+
+	Time_index<dtime_t> empty(std::vector<Job<dtime_t>>{}, &Job<dtime_t>::get_deadline);
+	CHECK(empty.lower_bound(3) == empty.end());
+}
+
+TEST_CASE("[basic] radix sort") {
+	typedef std::pair<std::uint64_t, std::size_t> Item;
+	auto key = [] (const Item& x) { return x.first; };
+
+	// long enough to be sorted byte by byte; few distinct keys, which
+	// differ only in some of their bytes
+	std::vector<Item> items;
+	for (std::size_t i = 0; i < 1000; i++)
+		items.emplace_back((i * 7919 % 13) << 40 | (i % 3), i);
+
+	auto expected = items;
+	std::stable_sort(expected.begin(), expected.end(),
+	                 [] (const Item& a, const Item& b) { return a.first < b.first; });
+
+	radix_sort(items, key);
+	CHECK(items == expected);
+
+	std::vector<Item> few{{3, 0}, {1, 1}, {3, 2}, {0, 3}};
+	radix_sort(few, key);
+	CHECK(few == std::vector<Item>{{0, 3}, {1, 1}, {3, 0}, {3, 2}});
+}
 
 TEST_CASE("state space") {
 
@@ -151,3 +209,115 @@ TEST_CASE("[basic] index set")
 	CHECK(!all.includes(c));
 }
 
+
+TEST_CASE("[basic] fixed-capacity index set")
+{
+	NP::Index_set empty{200};
+	NP::Index_set one{empty, 3};
+	NP::Index_set two{one, 130};
+	NP::Index_set other{one, 64};
+
+	CHECK(empty.size() == 0);
+	CHECK(one.size() == 1);
+	CHECK(two.size() == 2);
+	CHECK(two.contains(3));
+	CHECK(two.contains(130));
+	CHECK(!two.contains(64));
+	CHECK(!two.contains(1000));
+
+	CHECK(one.is_subset_of(two));
+	CHECK(!two.is_subset_of(one));
+	CHECK(!other.is_subset_of(two));
+	CHECK(two != other);
+
+	// sets of different capacities compare by their contents
+	NP::Index_set grown;
+	grown.add(3);
+	CHECK(grown == one);
+	grown.add(130);
+	CHECK(grown == two);
+	CHECK(grown.is_subset_of(two));
+	CHECK(two.is_subset_of(grown));
+
+	// adding beyond the capacity still works
+	NP::Index_set beyond{two, 300};
+	CHECK(beyond.contains(300));
+	CHECK(beyond.size() == 3);
+	CHECK(two.is_subset_of(beyond));
+	CHECK(beyond != two);
+
+	// round trip through the raw words
+	std::vector<NP::Index_set::Word> words(NP::Index_set::words_needed(200), 1);
+	two.copy_words(words.data(), words.size());
+	CHECK(words[0] == (1 << 3));
+	NP::Index_set copy{200, words.data()};
+	CHECK(copy == two);
+}
+
+TEST_CASE("[basic] persistent index set")
+{
+	NP::Persistent_index_set empty{5000};
+	NP::Persistent_index_set a{empty, 10};
+	NP::Persistent_index_set ab{a, 4000};
+	NP::Persistent_index_set b{empty, 4000};
+	NP::Persistent_index_set ba{b, 10};
+
+	CHECK(empty.size() == 0);
+	CHECK(a.size() == 1);
+	CHECK(ab.size() == 2);
+	CHECK(ab.contains(10));
+	CHECK(ab.contains(4000));
+	CHECK(!ab.contains(11));
+	CHECK(!ab.contains(100000));
+	CHECK(!a.contains(4000));
+
+	// the same set reached in different orders is the same set
+	CHECK(ab == ba);
+	CHECK(ab != a);
+	CHECK(a != b);
+
+	CHECK(empty.is_subset_of(a));
+	CHECK(a.is_subset_of(ab));
+	CHECK(b.is_subset_of(ab));
+	CHECK(!ab.is_subset_of(a));
+	CHECK(!a.is_subset_of(b));
+
+	std::vector<std::size_t> both{10, 4000};
+	std::vector<std::size_t> more{10, 4000, 4001};
+	CHECK(ab.includes(both));
+	CHECK(!ab.includes(more));
+	CHECK(!a.includes(both));
+
+	// growing sets compare by their contents
+	NP::Persistent_index_set grown;
+	grown.add(10);
+	CHECK(grown == a);
+	CHECK(grown.is_subset_of(ab));
+	grown.add(4000);
+	CHECK(grown == ab);
+	CHECK(ab.is_subset_of(grown));
+	grown.add(100000);
+	CHECK(grown.contains(100000));
+	CHECK(grown.size() == 3);
+	CHECK(grown != ab);
+	CHECK(ab.is_subset_of(grown));
+	CHECK(!grown.is_subset_of(ab));
+
+	NP::Persistent_index_set diff{ab, a};
+	CHECK(diff.size() == 1);
+	CHECK(diff.contains(4000));
+
+	// round trip through the raw words
+	std::vector<NP::Persistent_index_set::Word> words(
+		NP::Persistent_index_set::words_needed(5000), 1);
+	const auto& raw = words;
+	ab.copy_words(words.data(), words.size());
+	CHECK(words[0] == (1 << 10));
+	CHECK(words[4000 / 64] == NP::Persistent_index_set::Word(1) << (4000 % 64));
+	NP::Persistent_index_set copy{5000, raw.data()};
+	CHECK(copy == ab);
+	CHECK(copy.size() == 2);
+	empty.copy_words(words.data(), words.size());
+	NP::Persistent_index_set none{5000, raw.data()};
+	CHECK(none == empty);
+}
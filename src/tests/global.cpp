@@ -5,6 +5,7 @@
 
 #include "io.hpp"
 #include "global/space.hpp"
+#include "global/state_cache.hpp"
 
 const std::string fig1a_jobs_file =
 "   Task ID,     Job ID,          Arrival min,          Arrival max,             Cost min,             Cost max,             Deadline,             Priority\n"
@@ -25,12 +26,12 @@ TEST_CASE("[global-prec] basic state evolution (RTSS18-Fig-3)") {
 	CHECK(init.core_availability().min() == 0);
 	CHECK(init.core_availability().max() == 0);
 
-	NP::Global::Schedule_state<dtime_t> v1{init, 1, {}, {0, 0}, {5, 15}, 0};
+	NP::Global::Schedule_state<dtime_t> v1{init, 1, {}, {0, 0}, {5, 15}};
 
 	CHECK(v1.core_availability().min() == 0);
 	CHECK(v1.core_availability().max() == 0);
 
-	NP::Global::Schedule_state<dtime_t> vp{v1, 2, {}, {0, 0}, {12, 30}, 0};
+	NP::Global::Schedule_state<dtime_t> vp{v1, 2, {}, {0, 0}, {12, 30}};
 
 	CHECK(vp.core_availability().min() ==  5);
 	CHECK(vp.core_availability().max() == 15);
@@ -38,7 +39,7 @@ TEST_CASE("[global-prec] basic state evolution (RTSS18-Fig-3)") {
 	CHECK(!vp.can_merge_with(init));
 	CHECK(!vp.can_merge_with(v1));
 
-	NP::Global::Schedule_state<dtime_t> v2{init, 2, {}, {0, 0}, {10, 25}, 0};
+	NP::Global::Schedule_state<dtime_t> v2{init, 2, {}, {0, 0}, {10, 25}};
 
 	CHECK(v1.core_availability().min() == 0);
 	CHECK(v1.core_availability().max() == 0);
@@ -46,7 +47,7 @@ TEST_CASE("[global-prec] basic state evolution (RTSS18-Fig-3)") {
 	CHECK(!v2.can_merge_with(v1));
 	CHECK(!v2.try_to_merge(v1));
 
-	NP::Global::Schedule_state<dtime_t> vq{v2, 1, {}, {0, 0}, {8, 20}, 0};
+	NP::Global::Schedule_state<dtime_t> vq{v2, 1, {}, {0, 0}, {8, 20}};
 
 	CHECK(vq.core_availability().min() ==  8);
 	CHECK(vq.core_availability().max() == 20);
@@ -63,6 +64,177 @@ TEST_CASE("[global-prec] basic state evolution (RTSS18-Fig-3)") {
 	CHECK(vp.core_availability().max() == 20);
 }
 
+TEST_CASE("[global-prec] state evolution with inline core availability") {
+	typedef NP::Global::Schedule_state<dtime_t, 2> State;
+
+	State init(2);
+	State v1{init, 1, {}, {0, 0}, {5, 15}};
+	State vp{v1, 2, {}, {0, 0}, {12, 30}};
+
+	CHECK(vp.core_availability().min() ==  5);
+	CHECK(vp.core_availability().max() == 15);
+	CHECK(!vp.can_merge_with(v1));
+
+	State v2{init, 2, {}, {0, 0}, {10, 25}};
+	State vq{v2, 1, {}, {0, 0}, {8, 20}};
+
+	CHECK(vq.core_availability().min() ==  8);
+	CHECK(vq.core_availability().max() == 20);
+
+	CHECK(vp.try_to_merge(vq));
+
+	CHECK(vp.core_availability().min() ==  5);
+	CHECK(vp.core_availability().max() == 20);
+}
+
+TEST_CASE("[global] drafted successors") {
+	typedef NP::Global::Schedule_state<dtime_t> State;
+
+	State init(2, 4);
+	State v1{init, 1, {}, {0, 0}, {5, 15}};
+	State v2{init, 2, {}, {0, 0}, {10, 25}};
+	State vp{v1, 2, {}, {0, 0}, {12, 30}};
+
+	// the successor of v2 by job 1, as in the RTSS18 example
+	NP::Global::Successor_draft<dtime_t> draft;
+	v2.draft_successor(1, {}, {0, 0}, {8, 20}, draft);
+	State vq{v2, draft};
+
+	CHECK(vq.get_key() == vp.get_key());
+	CHECK(vq.core_availability().min() ==  8);
+	CHECK(vq.core_availability().max() == 20);
+	CHECK(vq.can_merge_with(vp));
+
+	// a draft merges only with states with the same jobs
+	CHECK(!v1.try_to_merge(v2, draft));
+	v2.draft_successor(3, {}, {0, 0}, {8, 20}, draft);
+	CHECK(!vp.try_to_merge(v2, draft));
+
+	v2.draft_successor(1, {}, {0, 0}, {8, 20}, draft);
+	CHECK(vp.try_to_merge(v2, draft));
+	CHECK(vp.core_availability().min() ==  5);
+	CHECK(vp.core_availability().max() == 20);
+
+	// disjoint core availabilities
+	v2.draft_successor(1, {}, {40, 40}, {45, 50}, draft);
+	CHECK(!vp.try_to_merge(v2, draft));
+}
+
+TEST_CASE("[global] job set fingerprints") {
+	NP::Global::Schedule_state<dtime_t> init(2, 4);
+
+	// the fingerprints depend on the positions of the jobs only
+	NP::Global::Schedule_state<dtime_t> a{init, 0, {}, {0, 0}, {1, 2}};
+	NP::Global::Schedule_state<dtime_t> b{init, 1, {}, {0, 0}, {1, 2}};
+	CHECK(a.get_key() != b.get_key());
+	CHECK(!a.can_merge_with(b, false));
+
+	NP::Global::Schedule_state<dtime_t> ab{a, 1, {}, {0, 0}, {1, 2}};
+	NP::Global::Schedule_state<dtime_t> ba{b, 0, {}, {0, 0}, {1, 2}};
+	CHECK(ab.get_key() == ba.get_key());
+	CHECK(ab.can_merge_with(ba, false));
+	CHECK(ab.try_to_merge(ba));
+
+	// jobs with identical parameters
+	NP::Job<dtime_t>::Job_set jobs;
+	for (unsigned long i = 0; i < 5; i++)
+		jobs.push_back(NP::Job<dtime_t>{1, Interval<dtime_t>(0, 5),
+		                                Interval<dtime_t>(1, 2), 20, 1, 1});
+
+	NP::Scheduling_problem<dtime_t> prob{jobs, 2};
+	NP::Analysis_options opts;
+	auto space = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	opts.trust_fingerprints = true;
+	auto trusting = NP::Global::State_space<dtime_t>::explore(prob, opts);
+
+	CHECK(space.is_schedulable());
+	CHECK(trusting.is_schedulable());
+#ifndef CONFIG_PARALLEL
+	CHECK(trusting.number_of_states() == space.number_of_states());
+#endif
+	for (std::size_t i = 0; i < jobs.size(); i++)
+		CHECK(trusting.get_finish_times(i) == space.get_finish_times(i));
+}
+
+TEST_CASE("[global] vectorized core availability merging") {
+	// odd length to exercise the scalar tail
+	const std::size_t n = 11;
+	long long a_lo[n], a_hi[n], b_lo[n], b_hi[n];
+	double da_lo[n], da_hi[n], db_lo[n], db_hi[n];
+
+	for (std::size_t i = 0; i < n; i++) {
+		a_lo[i] = 10 * i;     a_hi[i] = 10 * i + 5;
+		b_lo[i] = 10 * i + 6; b_hi[i] = 10 * i + 9;
+		da_lo[i] = a_lo[i];   da_hi[i] = a_hi[i];
+		db_lo[i] = b_lo[i];   db_hi[i] = b_hi[i];
+	}
+
+	// adjacent integer intervals still intersect
+	CHECK(NP::Global::Simd::all_intersect(a_lo, a_hi, b_lo, b_hi, n, 1LL));
+	CHECK_FALSE(NP::Global::Simd::all_intersect(da_lo, da_hi, db_lo, db_hi, n, 1e-9));
+
+	// a single disjoint pair anywhere is detected
+	for (std::size_t k = 0; k < n; k++) {
+		b_lo[k] += 1;
+		CHECK_FALSE(NP::Global::Simd::all_intersect(a_lo, a_hi, b_lo, b_hi, n, 1LL));
+		b_lo[k] -= 1;
+	}
+
+	NP::Global::Simd::widen(a_lo, a_hi, b_lo, b_hi, n);
+	NP::Global::Simd::widen(da_lo, da_hi, db_lo, db_hi, n);
+	for (std::size_t i = 0; i < n; i++) {
+		CHECK(a_lo[i] == 10 * i);
+		CHECK(a_hi[i] == 10 * i + 9);
+		CHECK(da_lo[i] == 10.0 * i);
+		CHECK(da_hi[i] == 10.0 * i + 9);
+	}
+}
+
+struct Cached_interval {
+	NP::hash_value_t key;
+	Interval<dtime_t> iv;
+
+	NP::hash_value_t get_key() const { return key; }
+
+	bool try_to_merge(const Cached_interval& other, bool = true)
+	{
+		if (key != other.key || !iv.intersects(other.iv))
+			return false;
+		iv |= other.iv;
+		return true;
+	}
+};
+
+TEST_CASE("[global] state cache") {
+	NP::Global::State_cache<Cached_interval> cache(4);
+	std::vector<Cached_interval> states;
+
+	// enough states to force the stripes to grow
+	for (int i = 0; i < 200; i++)
+		states.push_back(Cached_interval{NP::hash_value_t(i % 3), {10 * i, 10 * i + 5}});
+
+	for (auto& s : states)
+		CHECK(cache.merge_or_insert(&s) == &s);
+
+	Cached_interval a{1, {12, 14}};
+	Cached_interval b{2, {12, 14}};
+	Cached_interval c{7, {12, 14}};
+
+	// intersects with states[1], which has the same key
+	CHECK(cache.merge_or_insert(&a) == &states[1]);
+	CHECK(states[1].iv == Interval<dtime_t>{10, 15});
+	// same interval, but the key doesn't match
+	CHECK(cache.merge_or_insert(&b) == &b);
+	CHECK(cache.merge_or_insert(&c) == &c);
+
+	// the most recently cached state is tried first
+	Cached_interval d{2, {13, 13}};
+	CHECK(cache.merge_or_insert(&d) == &b);
+
+	cache.clear();
+	CHECK(cache.merge_or_insert(&a) == &a);
+}
+
 TEST_CASE("[global] RTSS17-Fig-1a") {
 	auto in = std::istringstream(fig1a_jobs_file);
 	auto jobs = NP::parse_csv_job_file<dtime_t>(in);
@@ -78,6 +250,11 @@ TEST_CASE("[global] RTSS17-Fig-1a") {
 
 	CHECK(space.is_schedulable());
 
+	auto sspace = NP::Global::State_space<dtime_t, 2>::explore(jobs, num_cpus);
+
+	CHECK(sspace.is_schedulable());
+	CHECK(sspace.number_of_states() == space.number_of_states());
+	CHECK(sspace.number_of_edges() == space.number_of_edges());
 
 	num_cpus = 1;
 	auto nspace2 = NP::Global::State_space<dtime_t>::explore_naively(jobs,
@@ -99,6 +276,91 @@ const std::string global_fig1_file =
 "5, 1, 8, 8, 1, 1, 14, 5\n";
 
 
+#ifndef CONFIG_PARALLEL
+#ifndef CONFIG_COLLECT_SCHEDULE_GRAPH
+TEST_CASE("[global] spill the exploration front to disk") {
+	// jobs with release jitter, which can be dispatched in many orders
+	NP::Job<dtime_t>::Job_set jobs;
+	for (unsigned long i = 0; i < 6; i++)
+		jobs.push_back(NP::Job<dtime_t>{i, Interval<dtime_t>(0, 10),
+		                                Interval<dtime_t>(1, 3), 20, dtime_t(i), i});
+
+	NP::Scheduling_problem<dtime_t> prob{jobs, 2};
+	NP::Analysis_options opts;
+
+	opts.be_naive = true;
+	auto nspace = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	opts.frontier_budget = 1;
+	auto nspilled = NP::Global::State_space<dtime_t>::explore(prob, opts);
+
+	// without merging, spilling changes nothing but the order
+	CHECK(nspilled.is_schedulable());
+	CHECK(nspilled.number_of_states() == nspace.number_of_states());
+	CHECK(nspilled.number_of_edges() == nspace.number_of_edges());
+	CHECK(nspilled.max_exploration_front_width() == nspace.max_exploration_front_width());
+
+	opts.be_naive = false;
+	opts.frontier_budget = 0;
+	auto space = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	opts.frontier_budget = 3;
+	auto spilled = NP::Global::State_space<dtime_t>::explore(prob, opts);
+
+	CHECK(spilled.is_schedulable());
+	// spilled states still merge when they are read back
+	CHECK(spilled.number_of_states() < nspace.number_of_states());
+	for (std::size_t i = 0; i < jobs.size(); i++) {
+		CHECK(spilled.get_finish_times(i).from() <= nspace.get_finish_times(i).from());
+		CHECK(spilled.get_finish_times(i).upto() >= nspace.get_finish_times(i).upto());
+	}
+
+	prob.num_processors = 1;
+	opts.frontier_budget = 1;
+	auto unschedulable = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	CHECK_FALSE(unschedulable.is_schedulable());
+}
+#endif
+#endif
+
+#ifndef CONFIG_COLLECT_SCHEDULE_GRAPH
+TEST_CASE("[global] merge by sorting each depth") {
+	NP::Job<dtime_t>::Job_set jobs;
+	for (unsigned long i = 0; i < 6; i++)
+		jobs.push_back(NP::Job<dtime_t>{i, Interval<dtime_t>(0, 10),
+		                                Interval<dtime_t>(1, 3), 20, dtime_t(i), i});
+
+	NP::Scheduling_problem<dtime_t> prob{jobs, 2};
+	NP::Analysis_options opts;
+
+	auto hashed = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	opts.be_naive = true;
+	auto naive = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	opts.be_naive = false;
+	opts.merge_strategy = NP::Merge_strategy::sorting;
+	auto sorted = NP::Global::State_space<dtime_t>::explore(prob, opts);
+
+	CHECK(sorted.is_schedulable());
+	CHECK(sorted.number_of_states() < naive.number_of_states());
+	for (std::size_t i = 0; i < jobs.size(); i++) {
+		CHECK(sorted.get_finish_times(i).from() <= naive.get_finish_times(i).from());
+		CHECK(sorted.get_finish_times(i).upto() >= naive.get_finish_times(i).upto());
+	}
+#ifndef CONFIG_PARALLEL
+	// both strategies offer each state to the same merge partners
+	CHECK(sorted.number_of_states() == hashed.number_of_states());
+	CHECK(sorted.number_of_edges() == hashed.number_of_edges());
+	CHECK(sorted.max_exploration_front_width() == hashed.max_exploration_front_width());
+	for (std::size_t i = 0; i < jobs.size(); i++) {
+		CHECK(sorted.get_finish_times(i).from() == hashed.get_finish_times(i).from());
+		CHECK(sorted.get_finish_times(i).upto() == hashed.get_finish_times(i).upto());
+	}
+#endif
+
+	prob.num_processors = 1;
+	auto unschedulable = NP::Global::State_space<dtime_t>::explore(prob, opts);
+	CHECK_FALSE(unschedulable.is_schedulable());
+}
+#endif
+
 TEST_CASE("[global] ECRTS18-Fig-1") {
 	auto in = std::istringstream(global_fig1_file);
 	auto jobs = NP::parse_csv_job_file<dtime_t>(in);
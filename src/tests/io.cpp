@@ -4,6 +4,8 @@
 #include <sstream>
 
 #include "io.hpp"
+#include "binary_io.hpp"
+#include "problem.hpp"
 
 const std::string one_line = "       920,          6,              50000.0,              50010.0,   23.227497252002234,    838.6724123730141,              60000.0,                    1";
 
@@ -57,6 +59,45 @@ TEST_CASE("[dense time] file parser") {
 	CHECK(jobs[2].get_deadline() == 30000);
 }
 
+TEST_CASE("[parser] job file from a buffer") {
+	const std::string lines =
+		"Task ID, Job ID, Arrival min, Arrival max, Cost min, Cost max, Deadline, Priority\n"
+		"1, 1, 0, 10, 2, 3, 100, 1, extra\n"
+		"  2,2,-5,+5,1,1,  9223372036854775807  ,7";
+
+	auto jobs = NP::parse_csv_job_file<dtime_t>(lines.data(), lines.data() + lines.size());
+
+	REQUIRE(jobs.size() == 2);
+	CHECK(jobs[0].get_task_id() == 1);
+	CHECK(jobs[0].latest_arrival() == 10);
+	CHECK(jobs[0].maximal_cost() == 3);
+	CHECK(jobs[1].get_task_id() == 2);
+	CHECK(jobs[1].earliest_arrival() == -5);
+	CHECK(jobs[1].latest_arrival() == 5);
+	CHECK(jobs[1].get_deadline() == 9223372036854775807LL);
+	CHECK(jobs[1].get_priority() == 7);
+
+	auto in = std::istringstream(four_lines);
+	auto dense = NP::parse_csv_job_file<dense_t>(in);
+	REQUIRE(dense.size() == 3);
+	CHECK(dense[2].maximal_cost() == 838.6724123730141);
+}
+
+TEST_CASE("[parser] job file errors report the line") {
+	auto in = std::istringstream(four_lines);
+
+	try {
+		NP::parse_csv_job_file<dtime_t>(in);
+		FAIL("dense job set parsed as discrete time");
+	} catch (NP::Parse_error& e) {
+		CHECK(e.line == 2);
+	}
+
+	const std::string overflow = "header\n1, 1, 0, 0, 1, 1, 99999999999999999999, 1\n";
+	REQUIRE_THROWS_AS(NP::parse_csv_job_file<dtime_t>(overflow.data(), overflow.data() + overflow.size()),
+	                  NP::Parse_error);
+}
+
 TEST_CASE("[disc time] don't parse dense files") {
 	auto in = std::istringstream(four_lines);
 
@@ -128,6 +169,39 @@ TEST_CASE("[parser] precedence file") {
 	CHECK(dag[2].second.job  == 13);
 }
 
+TEST_CASE("[parser] split at line boundaries") {
+	const std::string lines = "a\nbb\n\nccc\ndddd";
+	auto begin = lines.data(), end = lines.data() + lines.size();
+
+	for (std::size_t n = 1; n <= 8; n++) {
+		auto bounds = NP::split_lines(begin, end, n);
+		REQUIRE(bounds.size() == n + 1);
+		CHECK(bounds.front() == begin);
+		CHECK(bounds.back() == end);
+		for (std::size_t k = 1; k < n; k++) {
+			CHECK(bounds[k - 1] <= bounds[k]);
+			CHECK((bounds[k] == end || bounds[k][-1] == '\n'));
+		}
+	}
+}
+
+TEST_CASE("[parser] precedence file from a buffer") {
+	auto dag = NP::parse_dag_file(precedence_file.data(),
+	                              precedence_file.data() + precedence_file.size());
+
+	REQUIRE(dag.size() == 3);
+	CHECK(dag[2].first.task  == 2);
+	CHECK(dag[2].second.job  == 13);
+
+	const std::string bad = precedence_file + "1, 1, x, 2\n";
+	try {
+		NP::parse_dag_file(bad.data(), bad.data() + bad.size());
+		FAIL("incomplete precedence constraint accepted");
+	} catch (NP::Parse_error& e) {
+		CHECK(e.line == 5);
+	}
+}
+
 TEST_CASE("[parser] invalid precedence reference") {
 	auto dag_in = std::istringstream(precedence_file);
 	auto dag = NP::parse_dag_file(dag_in);
@@ -154,3 +228,114 @@ TEST_CASE("[parser] valid precedence reference") {
 	// dummy check; real check is that previous line didn't throw an exception
 	CHECK(true);
 }
+
+TEST_CASE("[parser] resolve precedence references") {
+	auto dag_in = std::istringstream(sequential_task_prec_file);
+	auto dag = NP::parse_dag_file(dag_in);
+
+	auto in = std::istringstream(four_lines);
+	NP::Scheduling_problem<dense_t> prob{NP::parse_csv_job_file<dense_t>(in), dag};
+
+	CHECK(prob.job_index.position_of(NP::JobID{3, 920}) == 2);
+	CHECK_FALSE(prob.job_index.contains(NP::JobID{4, 920}));
+	REQUIRE(prob.resolved_dag.size() == 2);
+	CHECK(prob.resolved_dag[0] == NP::Resolved_precedence_constraint(0, 1));
+	CHECK(prob.resolved_dag[1] == NP::Resolved_precedence_constraint(1, 2));
+}
+
+TEST_CASE("[parser] binary job sets") {
+	auto in = std::istringstream(four_lines);
+	auto jobs = NP::parse_csv_job_file<dense_t>(in);
+	auto dag_in = std::istringstream("header\n920, 1, 920, 2\n920, 2, 920, 3\n");
+	auto dag = NP::parse_dag_file(dag_in);
+	std::vector<NP::Abort_action<dense_t>> aborts{
+		NP::Abort_action<dense_t>{NP::JobID{3, 920}, Interval<dense_t>{30000, 30010},
+		                          Interval<dense_t>{1.5, 2.5}}};
+
+	std::ostringstream out;
+	NP::write_binary_job_set<dense_t>(out, jobs, dag, aborts);
+	auto data = out.str();
+	auto begin = data.data(), end = data.data() + data.size();
+
+	REQUIRE(NP::is_binary_job_set(begin, end));
+	auto input = NP::parse_binary_job_set<dense_t>(begin, end);
+
+	REQUIRE(input.jobs.size() == jobs.size());
+	for (std::size_t i = 0; i < jobs.size(); i++) {
+		CHECK(input.jobs[i].get_id() == jobs[i].get_id());
+		CHECK(input.jobs[i].arrival_window() == jobs[i].arrival_window());
+		CHECK(input.jobs[i].get_cost() == jobs[i].get_cost());
+		CHECK(input.jobs[i].get_deadline() == jobs[i].get_deadline());
+		CHECK(input.jobs[i].get_priority() == jobs[i].get_priority());
+		CHECK(input.jobs[i].get_key() == jobs[i].get_key());
+	}
+	CHECK(input.edges == dag);
+	REQUIRE(input.aborts.size() == 1);
+	CHECK(input.aborts[0].get_id() == aborts[0].get_id());
+	CHECK(input.aborts[0].maximum_cleanup_cost() == 2.5);
+
+	// wrong time model, truncated data, not a binary job set at all
+	CHECK_THROWS_AS(NP::parse_binary_job_set<dtime_t>(begin, end), std::invalid_argument);
+	CHECK_THROWS_AS(NP::parse_binary_job_set<dense_t>(begin, end - 1), std::ios_base::failure);
+	CHECK_FALSE(NP::is_binary_job_set(four_lines.data(), four_lines.data() + four_lines.size()));
+}
+
+const std::string yaml_job_set =
+"jobset:\n"
+"  - Task ID: 1\n"
+"    Job ID: 1\n"
+"    Arrival min: 0\n"
+"    Arrival max: 5\n"
+"    Cost min: 1\n"
+"    Cost max: 2\n"
+"    Deadline: 10\n"
+"    Priority: 10\n"
+"    Successors: [[1, 2], [2, 1]]\n"
+"  - Successors:\n"
+"      - Task ID: 2\n"
+"        Job ID: 1\n"
+"    Task ID: 1\n"
+"    Job ID: 2\n"
+"    Arrival min: &t 10\n"
+"    Arrival max: *t\n"
+"    Cost min: 1\n"
+"    Cost max: 2\n"
+"    Deadline: 20\n"
+"    Priority: 20\n"
+"    Comment: {ignored: [1, 2]}\n"
+"  - {Task ID: 2, Job ID: 1, Arrival min: 0, Arrival max: 0,\n"
+"     Cost min: 3, Cost max: 3, Deadline: 30, Priority: 30}\n";
+
+TEST_CASE("[parser] YAML job set in one pass") {
+	auto in = std::istringstream(yaml_job_set);
+	NP::Precedence_constraints dag;
+
+	auto jobs = NP::parse_yaml_job_set<dtime_t>(in, dag);
+
+	REQUIRE(jobs.size() == 3);
+	CHECK(jobs[0].latest_arrival() == 5);
+	CHECK(jobs[1].get_id() == NP::JobID(2, 1));
+	CHECK(jobs[1].arrival_window() == Interval<dtime_t>{10, 10});
+	CHECK(jobs[2].maximal_cost() == 3);
+
+	REQUIRE(dag.size() == 3);
+	CHECK(dag[0] == NP::Precedence_constraint(NP::JobID(1, 1), NP::JobID(2, 1)));
+	CHECK(dag[1] == NP::Precedence_constraint(NP::JobID(1, 1), NP::JobID(1, 2)));
+	CHECK(dag[2] == NP::Precedence_constraint(NP::JobID(2, 1), NP::JobID(1, 2)));
+
+	auto dag_in = std::istringstream(yaml_job_set);
+	CHECK(NP::parse_yaml_dag_file(dag_in) == dag);
+}
+
+TEST_CASE("[parser] malformed YAML job set") {
+	// cut off in the middle of the last job
+	auto cut = yaml_job_set.substr(0, yaml_job_set.find("Cost min: 3"));
+	NP::Precedence_constraints dag;
+
+	auto in = std::istringstream(cut);
+	CHECK_THROWS_AS(NP::read_yaml_job_set<dtime_t>(in, dag), YAML::Exception);
+
+	auto whole = std::istringstream(yaml_job_set);
+	NP::Precedence_constraints all;
+	CHECK(NP::read_yaml_job_set<dtime_t>(whole, all).size() == 3);
+}